@@ -0,0 +1,194 @@
+/**
+ * @file aabb.cpp
+ * @brief This file contains the axis aligned bounding box class
+ */
+
+#ifndef AABB_H
+#define AABB_H
+
+#include <cmath>
+
+#include "1805086_line.cpp"
+#include "1805086_ray_packet.cpp"
+#include "1805086_vector3d.cpp"
+
+using namespace std;
+
+/**
+ * @brief The AABB class
+ * axis aligned bounding box given by its lowest and highest corner
+ */
+class AABB {
+ public:
+  double low[3];
+  double high[3];
+
+  /**
+   * @brief empty box, expanding it by anything gives that thing's box
+   */
+  AABB() {
+    for (int i = 0; i < 3; i++) {
+      low[i] = INFINITY;
+      high[i] = -INFINITY;
+    }
+  }
+
+  /**
+   * @brief box spanned by two corners
+   */
+  AABB(Vector3D low_corner, Vector3D high_corner) {
+    for (int i = 0; i < 3; i++) {
+      low[i] = low_corner[i];
+      high[i] = high_corner[i];
+    }
+  }
+
+  /**
+   * @brief grow the box so that it contains the point
+   */
+  void expand(Vector3D point) {
+    for (int i = 0; i < 3; i++) {
+      low[i] = min(low[i], point[i]);
+      high[i] = max(high[i], point[i]);
+    }
+  }
+
+  /**
+   * @brief grow the box so that it contains another box
+   */
+  void expand(const AABB& box) {
+    for (int i = 0; i < 3; i++) {
+      low[i] = min(low[i], box.low[i]);
+      high[i] = max(high[i], box.high[i]);
+    }
+  }
+
+  /**
+   * @brief grow the box by an amount on every side
+   */
+  void pad(double amount) {
+    for (int i = 0; i < 3; i++) {
+      low[i] -= amount;
+      high[i] += amount;
+    }
+  }
+
+  /**
+   * @brief the center of the box along an axis
+   */
+  double centroid(int axis) const { return 0.5 * (low[axis] + high[axis]); }
+
+  /**
+   * @brief whether the point is inside the box or on its boundary
+   */
+  bool contains(const Vector3D& point) const {
+    for (int i = 0; i < 3; i++) {
+      if (point[i] < low[i] || point[i] > high[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief the area of the surface of the box, 0 for an empty box
+   */
+  double surfaceArea() const {
+    double size[3];
+    for (int i = 0; i < 3; i++) {
+      size[i] = high[i] - low[i];
+      if (!(size[i] >= 0)) {
+        return 0;
+      }
+    }
+    return 2 * (size[0] * size[1] + size[1] * size[2] + size[2] * size[0]);
+  }
+
+  /**
+   * @brief the axis along which the box is the longest
+   */
+  int longestAxis() const {
+    int axis = 0;
+    for (int i = 1; i < 3; i++) {
+      if (high[i] - low[i] > high[axis] - low[axis]) {
+        axis = i;
+      }
+    }
+    return axis;
+  }
+
+  /**
+   * @brief the largest absolute value of any coordinate of the box
+   */
+  double magnitude() const {
+    double result = 0;
+    for (int i = 0; i < 3; i++) {
+      result = max(result, max(fabs(low[i]), fabs(high[i])));
+    }
+    return result;
+  }
+
+  /**
+   * @brief slab test of a ray against the box
+   * an axis for which the slab distances are not defined (the ray lies in one
+   * of the bounding planes) does not restrict the interval
+   * @param origin the start of the ray
+   * @param inverse_direction 1 / direction of the ray, per axis
+   * @param t_max the far end of the interval that is searched
+   * @param t_enter set to the distance at which the ray enters the box
+   * @return true if the ray overlaps the box within [0, t_max]
+   */
+  bool intersect(const double origin[3],
+                 const double inverse_direction[3],
+                 double t_max,
+                 double& t_enter) const {
+    double t_exit = t_max;
+    t_enter = 0;
+    for (int i = 0; i < 3; i++) {
+      double t0 = (low[i] - origin[i]) * inverse_direction[i];
+      double t1 = (high[i] - origin[i]) * inverse_direction[i];
+      if (t0 > t1) {
+        double temp = t0;
+        t0 = t1;
+        t1 = temp;
+      }
+      if (t0 > t_enter) {
+        t_enter = t0;
+      }
+      if (t1 < t_exit) {
+        t_exit = t1;
+      }
+      if (t_enter > t_exit) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief slab test of a packet of rays against the box
+   * an axis with an undefined slab distance (NaN) does not restrict the
+   * interval at all, which can only let more rays through than the single
+   * ray test
+   * @param packet the rays
+   * @param t_max the far end of the interval that is searched, per ray
+   * @return mask of the rays that overlap the box within [0, t_max]
+   */
+  Mask4 intersect(RayPacket& packet, const Double4& t_max) const {
+    Double4 t_enter(0.0);
+    Double4 t_exit = t_max;
+    for (int i = 0; i < 3; i++) {
+      Double4 origin = packet.getOrigin(i);
+      Double4 inverse_direction = packet.getInverseDirection(i);
+      Double4 t0 = (Double4(low[i]) - origin) * inverse_direction;
+      Double4 t1 = (Double4(high[i]) - origin) * inverse_direction;
+      // NaN compares false even against itself
+      Mask4 defined = (t0 <= t0) & (t1 <= t1);
+      t_enter = select(defined, max(min(t0, t1), t_enter), t_enter);
+      t_exit = select(defined, min(max(t0, t1), t_exit), t_exit);
+    }
+    return t_enter <= t_exit;
+  }
+};
+
+#endif  // AABB_H
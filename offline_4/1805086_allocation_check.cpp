@@ -0,0 +1,109 @@
+/**
+ * @file allocation_check.cpp
+ * @brief This file contains the check that shading does not allocate
+ * every pixel of a generated scene is shaded twice on the calling thread,
+ * with single rays and with ray packets, with every light, with the lights
+ * culled and with the lights sampled. the heap allocations of the second
+ * pass are counted, it prints them as one JSON object per case and exits
+ * with 1 if there is any.
+ *
+ * g++ -O2 -DHEADLESS 1805086_allocation_check.cpp -o allocation_check -pthread
+ * ./allocation_check
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "1805086_allocation_counter.cpp"
+#include "1805086_renderer.cpp"
+#include "1805086_scene_generator.cpp"
+
+using namespace std;
+
+/**
+ * @brief a way of picking the lights of a hit
+ */
+struct LightMode {
+  string name;
+  double threshold;
+  int samples;
+};
+
+/**
+ * @brief shade every pixel of the frame once
+ */
+void shade_frame(RayGenerator& generator,
+                 FrameBuffer* frame_buffer,
+                 bool packets) {
+  int width = get_image_width();
+  for (int y = 0; y < number_of_pixels_y; y++) {
+    for (int x = 0; x < width; x += packets ? SIMD_WIDTH : 1) {
+      if (packets) {
+        shade_pixels(generator, x, y, min(SIMD_WIDTH, width - x),
+                     frame_buffer);
+      } else {
+        PixelLineMap pixel_line = generator.getPixelLine(x, y);
+        shade_pixel(pixel_line, frame_buffer);
+      }
+    }
+  }
+}
+
+int main() {
+  SceneGenerator generator(1805086, 40, 20, 20, 24, 8);
+  ostringstream text;
+  generator.write(text, 90, 3);
+  string scene_text = text.str();
+  SceneParser parser;
+  SceneDescription scene;
+  if (!parser.parse(scene_text.data(), scene_text.data() + scene_text.size(),
+                    scene)) {
+    cerr << parser.getError() << endl;
+    return 1;
+  }
+
+  streambuf* console = cout.rdbuf(NULL);
+  load_scene(scene);
+  cout.rdbuf(console);
+  cout.clear();
+  camera = Vector3D(100, 100, 100);
+  look = Vector3D(0, 0, 0);
+  up = Vector3D(0, 0, 1);
+
+  LightMode modes[] = {{"every light", 0, 0},
+                       {"culled", 1e-3, 0},
+                       {"sampled", 0, 4}};
+  bool passed = true;
+  for (const LightMode& mode : modes) {
+    light_threshold = mode.threshold;
+    light_samples = mode.samples;
+    cout.rdbuf(NULL);
+    build_acceleration_structure();
+    cout.rdbuf(console);
+    cout.clear();
+
+    RayGenerator rays(camera, look, up, near_plane, fov_y, aspect_ratio,
+                      number_of_pixels_y);
+    FrameBuffer frame_buffer(get_image_width(), number_of_pixels_y);
+    SceneView view = get_scene_view();
+    render_context.setView(view);
+
+    for (bool packets : {false, true}) {
+      long long start = count_allocations();
+      shade_frame(rays, &frame_buffer, packets);
+      long long first_pass = count_allocations() - start;
+      start = count_allocations();
+      shade_frame(rays, &frame_buffer, packets);
+      long long second_pass = count_allocations() - start;
+      passed = passed && second_pass == 0;
+
+      cout << "{\"lights\": \"" << mode.name << "\", \"packets\": "
+           << (packets ? "true" : "false")
+           << ", \"pixels\": " << get_image_width() * number_of_pixels_y
+           << ", \"first_pass_allocations\": " << first_pass
+           << ", \"allocations\": " << second_pass << "}" << endl;
+    }
+  }
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file allocation_counter.cpp
+ * @brief This file contains a counting replacement of the global operator new
+ * a program that includes it (once) counts every heap allocation made by any
+ * of its threads, the allocation check uses it to make sure that shading
+ * does not allocate. the renderer itself never includes it.
+ */
+
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+atomic<long long> heap_allocations(0);
+
+/**
+ * @brief the number of heap allocations since the program started
+ */
+long long count_allocations() { return heap_allocations.load(); }
+
+void* operator new(size_t size) {
+  heap_allocations++;
+  void* memory = malloc(size == 0 ? 1 : size);
+  if (memory == NULL) {
+    throw bad_alloc();
+  }
+  return memory;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+// types aligned beyond what malloc guarantees, like Double4 with AVX
+void* operator new(size_t size, align_val_t alignment) {
+  heap_allocations++;
+  // aligned_alloc wants a whole number of alignments
+  size_t bytes = (size_t)alignment;
+  size = size == 0 ? bytes : (size + bytes - 1) / bytes * bytes;
+  void* memory = aligned_alloc(bytes, size);
+  if (memory == NULL) {
+    throw bad_alloc();
+  }
+  return memory;
+}
+
+void* operator new[](size_t size, align_val_t alignment) {
+  return operator new(size, alignment);
+}
+
+void operator delete(void* memory) noexcept { free(memory); }
+
+void operator delete[](void* memory) noexcept { free(memory); }
+
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+
+void operator delete(void* memory, align_val_t) noexcept { free(memory); }
+
+void operator delete[](void* memory, align_val_t) noexcept { free(memory); }
+
+void operator delete(void* memory, size_t, align_val_t) noexcept {
+  free(memory);
+}
+
+void operator delete[](void* memory, size_t, align_val_t) noexcept {
+  free(memory);
+}
+
+#endif  // ALLOCATION_COUNTER_H
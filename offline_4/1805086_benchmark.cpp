@@ -0,0 +1,221 @@
+/**
+ * @file benchmark.cpp
+ * @brief This file contains the ray tracer benchmark
+ * renders generated scenes of increasing size at several resolutions and
+ * levels of recursion without opening a window and writes the throughput of
+ * every run as JSON (or CSV if the output file ends with .csv).
+ *
+ * g++ -O2 -DHEADLESS 1805086_benchmark.cpp -o benchmark -pthread
+ * ./benchmark [output file, default benchmark.json] [number of threads]
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "1805086_renderer.cpp"
+#include "1805086_scene_generator.cpp"
+
+using namespace std;
+
+/**
+ * @brief a generated scene of the benchmark
+ */
+struct BenchmarkScene {
+  string name;
+  unsigned int seed;
+  int spheres, cubes, pyramids, lights, spot_lights;
+};
+
+/**
+ * @brief the measurements of one render
+ */
+struct BenchmarkResult {
+  string scene;
+  unsigned int seed;
+  int shapes, lights;
+  int width, height;
+  int level_of_recursion;
+  int threads;
+  double render_ms;
+  RenderStatistics statistics;
+  long long peak_rss_kb;
+};
+
+/**
+ * @brief the peak resident set size of the process in kB, 0 if unknown
+ */
+long long read_peak_rss_kb() {
+  ifstream status("/proc/self/status");
+  string line;
+  while (getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      return atoll(line.c_str() + 6);
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief start measuring the peak resident set size from the current size
+ * (linux only, elsewhere the peak of the whole process is reported)
+ */
+void reset_peak_rss() {
+  ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5" << endl;
+}
+
+/**
+ * @brief generate, load and render one scene
+ */
+BenchmarkResult run(BenchmarkScene& scene,
+                    int number_of_pixels,
+                    int recursion_level) {
+  SceneGenerator generator(scene.seed, scene.spheres, scene.cubes,
+                           scene.pyramids, scene.lights, scene.spot_lights);
+  string filename = "benchmark_" + scene.name + ".txt";
+  {
+    ofstream file(filename.c_str());
+    generator.write(file, number_of_pixels, recursion_level);
+  }
+
+  // the renderer reports the scene on cout, which is kept quiet during the run
+  streambuf* console = cout.rdbuf(NULL);
+  clear_scene();
+  load_parameters(filename);
+  remove(filename.c_str());
+  build_acceleration_structure();
+
+  reset_peak_rss();
+  auto start = chrono::steady_clock::now();
+  FrameBuffer* frame_buffer = generate_image();
+  auto end = chrono::steady_clock::now();
+  delete frame_buffer;
+  cout.rdbuf(console);
+  cout.clear();
+
+  BenchmarkResult result;
+  result.scene = scene.name;
+  result.seed = scene.seed;
+  result.shapes = generator.getNumberOfShapes();
+  result.lights = generator.getNumberOfLights();
+  result.width = get_image_width();
+  result.height = number_of_pixels_y;
+  result.level_of_recursion = level_of_recursion;
+  result.threads = number_of_threads;
+  result.render_ms = chrono::duration<double, milli>(end - start).count();
+  result.statistics = frame_statistics;
+  result.peak_rss_kb = read_peak_rss_kb();
+  return result;
+}
+
+double rays_per_second(long long rays, double ms) {
+  return rays / (ms / 1000);
+}
+
+/**
+ * @brief writes the results as a JSON array of objects
+ */
+void write_json(ostream& out, vector<BenchmarkResult>& results) {
+  out << "[" << endl;
+  for (int i = 0; i < results.size(); i++) {
+    BenchmarkResult& r = results[i];
+    long long rays = r.statistics.getTotalRays();
+    out << "  {\"scene\": \"" << r.scene << "\", \"seed\": " << r.seed
+        << ", \"shapes\": " << r.shapes << ", \"lights\": " << r.lights
+        << ", \"width\": " << r.width << ", \"height\": " << r.height
+        << ", \"recursion_level\": " << r.level_of_recursion
+        << ", \"threads\": " << r.threads << ", \"render_ms\": " << r.render_ms
+        << ", \"primary_rays\": " << r.statistics.primary_rays
+        << ", \"shadow_rays\": " << r.statistics.shadow_rays
+        << ", \"reflection_rays\": " << r.statistics.reflection_rays
+        << ", \"rays_per_second\": " << rays_per_second(rays, r.render_ms)
+        << ", \"ns_per_ray\": " << r.render_ms * 1e6 / rays
+        << ", \"shadow_rays_per_second\": "
+        << rays_per_second(r.statistics.shadow_rays, r.render_ms)
+        << ", \"peak_rss_kb\": " << r.peak_rss_kb << "}"
+        << (i + 1 < results.size() ? "," : "") << endl;
+  }
+  out << "]" << endl;
+}
+
+/**
+ * @brief writes the results as CSV with a header line
+ */
+void write_csv(ostream& out, vector<BenchmarkResult>& results) {
+  out << "scene,seed,shapes,lights,width,height,recursion_level,threads,"
+         "render_ms,primary_rays,shadow_rays,reflection_rays,"
+         "rays_per_second,ns_per_ray,shadow_rays_per_second,peak_rss_kb"
+      << endl;
+  for (int i = 0; i < results.size(); i++) {
+    BenchmarkResult& r = results[i];
+    long long rays = r.statistics.getTotalRays();
+    out << r.scene << "," << r.seed << "," << r.shapes << "," << r.lights
+        << "," << r.width << "," << r.height << "," << r.level_of_recursion
+        << "," << r.threads << "," << r.render_ms << ","
+        << r.statistics.primary_rays << "," << r.statistics.shadow_rays << ","
+        << r.statistics.reflection_rays << ","
+        << rays_per_second(rays, r.render_ms) << ","
+        << r.render_ms * 1e6 / rays << ","
+        << rays_per_second(r.statistics.shadow_rays, r.render_ms) << ","
+        << r.peak_rss_kb << endl;
+  }
+}
+
+int main(int argc, char** argv) {
+  string output = argc > 1 ? argv[1] : "benchmark.json";
+  if (argc > 2) {
+    number_of_threads = max(1, atoi(argv[2]));
+  }
+
+  // the progress of a run would only disturb its timing
+  progress_mode = PROGRESS_QUIET;
+
+  // the same camera as the viewer starts with
+  camera = Vector3D(100, 100, 100);
+  look = Vector3D(0, 0, 0);
+  up = Vector3D(0, 0, 1);
+
+  BenchmarkScene scenes[] = {
+      {"small", 1, 8, 4, 4, 2, 1},
+      {"medium", 2, 64, 32, 32, 4, 2},
+      {"large", 3, 512, 256, 256, 8, 4},
+  };
+  int resolutions[] = {180, 360, 720};
+  int recursion_levels[] = {1, 3};
+
+  vector<BenchmarkResult> results;
+  for (BenchmarkScene& scene : scenes) {
+    for (int number_of_pixels : resolutions) {
+      for (int recursion_level : recursion_levels) {
+        BenchmarkResult result = run(scene, number_of_pixels, recursion_level);
+        results.push_back(result);
+        cout << result.scene << " " << result.width << "x" << result.height
+             << " recursion " << result.level_of_recursion << " : "
+             << result.render_ms << " ms, "
+             << rays_per_second(result.statistics.getTotalRays(),
+                                result.render_ms) /
+                    1e6
+             << " Mrays/s" << endl;
+      }
+    }
+  }
+  clear_scene();
+
+  ofstream file(output.c_str());
+  if (!file) {
+    cerr << "cannot write " << output << endl;
+    return 1;
+  }
+  bool csv = output.size() >= 4 && output.compare(output.size() - 4, 4,
+                                                  ".csv") == 0;
+  if (csv) {
+    write_csv(file, results);
+  } else {
+    write_json(file, results);
+  }
+  cout << "results written to " << output << endl;
+  return 0;
+}
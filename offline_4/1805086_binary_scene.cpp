@@ -0,0 +1,443 @@
+/**
+ * @file binary_scene.cpp
+ * @brief This file contains the binary scene format
+ * a binary scene holds the same scene as a scene.txt file in fixed size
+ * little endian records. a header is followed by one contiguous array per
+ * kind of object, the shapes refer to their material by index. the file is
+ * memory mapped and its arrays are read in place, there is nothing to parse.
+ * a binary scene can also be read from memory, the scene cache holds one.
+ */
+
+#ifndef BINARY_SCENE_H
+#define BINARY_SCENE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "1805086_mapped_file.cpp"
+#include "1805086_scene_parser.cpp"
+
+using namespace std;
+
+const char BINARY_SCENE_MAGIC[8] = {'R', 'T', 'S', 'C', 'E', 'N', 'E', '\0'};
+const uint32_t BINARY_SCENE_VERSION = 1;
+
+/**
+ * @brief where an array of records starts in the file and how many records
+ * it has
+ */
+struct BinarySceneArray {
+  uint64_t offset;
+  uint64_t count;
+};
+
+struct BinarySceneHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  double near_plane, far_plane, fov_y, aspect_ratio;
+  int32_t level_of_recursion;
+  int32_t number_of_pixels_y;
+  // the checker board
+  double width_of_cell;
+  double ambient_coefficient, diffuse_coefficient, reflection_coefficient;
+
+  BinarySceneArray materials;
+  BinarySceneArray spheres;
+  BinarySceneArray cubes;
+  BinarySceneArray pyramids;
+  BinarySceneArray lights;
+  BinarySceneArray spot_lights;
+};
+
+struct BinaryMaterial {
+  float color[3];
+  int32_t shine;
+  double ambient, diffuse, specular, reflection;
+};
+
+struct BinarySphere {
+  double center[3];
+  double radius;
+  uint32_t material;
+  uint32_t padding;
+};
+
+struct BinaryCube {
+  double corner[3];
+  double side;
+  uint32_t material;
+  uint32_t padding;
+};
+
+struct BinaryPyramid {
+  double base[3];
+  double width, height;
+  uint32_t material;
+  uint32_t padding;
+};
+
+struct BinaryLight {
+  double position[3];
+  double falloff;
+};
+
+struct BinarySpotLight {
+  double position[3];
+  double falloff;
+  double pointing[3];
+  double angle;
+};
+
+// the layout is fixed, the records are read straight out of the file
+static_assert(sizeof(BinarySceneHeader) == 184, "binary scene header layout");
+static_assert(sizeof(BinaryMaterial) == 48, "binary material layout");
+static_assert(sizeof(BinarySphere) == 40, "binary sphere layout");
+static_assert(sizeof(BinaryCube) == 40, "binary cube layout");
+static_assert(sizeof(BinaryPyramid) == 48, "binary pyramid layout");
+static_assert(sizeof(BinaryLight) == 32, "binary light layout");
+static_assert(sizeof(BinarySpotLight) == 64, "binary spot light layout");
+
+/**
+ * @brief whether the records can be used as they are stored, the format is
+ * little endian
+ */
+inline bool is_little_endian() {
+  uint32_t one = 1;
+  unsigned char first;
+  memcpy(&first, &one, 1);
+  return first == 1;
+}
+
+/**
+ * @brief a 64 bit hash of a block of memory, FNV-1a over 8 bytes at a time
+ */
+uint64_t hash_bytes(const char* data, size_t size) {
+  const uint64_t prime = 0x100000001b3ULL;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, data + i, 8);
+    hash = (hash ^ word) * prime;
+    hash ^= hash >> 29;
+  }
+  for (; i < size; i++) {
+    hash = (hash ^ (unsigned char)data[i]) * prime;
+  }
+  return hash;
+}
+
+/**
+ * @brief hashes a material by its bytes, materials with the same bytes share
+ * a record
+ */
+struct BinaryMaterialHash {
+  size_t operator()(const BinaryMaterial& material) const {
+    return hash_bytes((const char*)&material, sizeof(material));
+  }
+};
+
+struct BinaryMaterialEqual {
+  bool operator()(const BinaryMaterial& a, const BinaryMaterial& b) const {
+    return memcmp(&a, &b, sizeof(a)) == 0;
+  }
+};
+
+/**
+ * @brief whether a block of memory starts like a binary scene
+ */
+inline bool is_binary_scene(const char* data, size_t size) {
+  return size >= sizeof(BINARY_SCENE_MAGIC) &&
+         memcmp(data, BINARY_SCENE_MAGIC, sizeof(BINARY_SCENE_MAGIC)) == 0;
+}
+
+/**
+ * @brief The BinaryScene class
+ * a memory mapped binary scene, the arrays stay valid until the scene is
+ * closed or destroyed
+ */
+class BinaryScene {
+ private:
+  MappedFile file;
+  const char* data;
+  size_t size;
+  string error;
+
+  /**
+   * @brief checks that an array of records lies inside the file
+   */
+  bool checkArray(const BinarySceneArray& array,
+                  size_t record_size,
+                  const char* name) {
+    if (array.offset % 8 != 0 || array.offset > size ||
+        array.count > (size - array.offset) / record_size) {
+      error = string("the ") + name + " lie outside the file";
+      return false;
+    }
+    return true;
+  }
+
+  template <typename Record>
+  const Record* getArray(const BinarySceneArray& array) const {
+    return (const Record*)(data + array.offset);
+  }
+
+  /**
+   * @brief checks that the shapes of an array only use existing materials
+   */
+  template <typename Record>
+  bool checkMaterials(const BinarySceneArray& array, const char* name) {
+    const Record* records = getArray<Record>(array);
+    for (uint64_t i = 0; i < array.count; i++) {
+      if (records[i].material >= getHeader().materials.count) {
+        error = string("one of the ") + name + " has no material";
+        return false;
+      }
+    }
+    return true;
+  }
+
+ public:
+  BinaryScene() : data(NULL), size(0) {}
+  ~BinaryScene() { close(); }
+
+  BinaryScene(const BinaryScene&) = delete;
+  BinaryScene& operator=(const BinaryScene&) = delete;
+
+  /**
+   * @brief whether a file starts like a binary scene
+   */
+  static bool isBinaryScene(const string& filename) {
+    char magic[sizeof(BINARY_SCENE_MAGIC)];
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (file == NULL) {
+      return false;
+    }
+    bool binary = is_binary_scene(
+        magic, fread(magic, 1, sizeof(magic), file));
+    fclose(file);
+    return binary;
+  }
+
+  /**
+   * @brief why the last open failed
+   */
+  const string& getError() { return error; }
+
+  /**
+   * @brief maps a binary scene and checks its header and arrays
+   * @return false if the file cannot be read or is not a valid binary scene,
+   * see getError()
+   */
+  bool open(const string& filename) {
+    close();
+    if (!file.open(filename)) {
+      error = "cannot read " + filename;
+      return false;
+    }
+    if (!open(file.getData(), file.getSize())) {
+      error = filename + ": " + error;
+      file.close();
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief checks the header and arrays of a binary scene in memory, which
+   * has to stay valid as long as the scene is open
+   * @param data the start of the scene, aligned to 8 bytes
+   * @return false if it is not a valid binary scene, see getError()
+   */
+  bool open(const char* data, size_t size) {
+    error.clear();
+    if (!is_little_endian()) {
+      error = "binary scenes are little endian";
+      return false;
+    }
+    this->data = data;
+    this->size = size;
+
+    bool valid = size >= sizeof(BinarySceneHeader) &&
+                 is_binary_scene(data, size);
+    const BinarySceneHeader& header = getHeader();
+    if (!valid) {
+      error = "not a binary scene";
+    } else if (header.version != BINARY_SCENE_VERSION ||
+               header.header_size != sizeof(BinarySceneHeader)) {
+      error = "binary scene version " + to_string(header.version) +
+              " is not supported";
+      valid = false;
+    } else {
+      valid =
+          checkArray(header.materials, sizeof(BinaryMaterial), "materials") &&
+          checkArray(header.spheres, sizeof(BinarySphere), "spheres") &&
+          checkArray(header.cubes, sizeof(BinaryCube), "cubes") &&
+          checkArray(header.pyramids, sizeof(BinaryPyramid), "pyramids") &&
+          checkArray(header.lights, sizeof(BinaryLight), "lights") &&
+          checkArray(header.spot_lights, sizeof(BinarySpotLight),
+                     "spot lights") &&
+          checkMaterials<BinarySphere>(header.spheres, "spheres") &&
+          checkMaterials<BinaryCube>(header.cubes, "cubes") &&
+          checkMaterials<BinaryPyramid>(header.pyramids, "pyramids");
+    }
+    if (!valid) {
+      this->data = NULL;
+      this->size = 0;
+    }
+    return valid;
+  }
+
+  /**
+   * @brief unmaps the scene
+   */
+  void close() {
+    file.close();
+    data = NULL;
+    size = 0;
+  }
+
+  const BinarySceneHeader& getHeader() const {
+    return *(const BinarySceneHeader*)data;
+  }
+  const BinaryMaterial* getMaterials() const {
+    return getArray<BinaryMaterial>(getHeader().materials);
+  }
+  const BinarySphere* getSpheres() const {
+    return getArray<BinarySphere>(getHeader().spheres);
+  }
+  const BinaryCube* getCubes() const {
+    return getArray<BinaryCube>(getHeader().cubes);
+  }
+  const BinaryPyramid* getPyramids() const {
+    return getArray<BinaryPyramid>(getHeader().pyramids);
+  }
+  const BinaryLight* getLights() const {
+    return getArray<BinaryLight>(getHeader().lights);
+  }
+  const BinarySpotLight* getSpotLights() const {
+    return getArray<BinarySpotLight>(getHeader().spot_lights);
+  }
+};
+
+/**
+ * @brief appends an array of records to the file contents and notes where
+ * it is in the header
+ */
+template <typename Record>
+void append_array(vector<char>& contents,
+                  const vector<Record>& records,
+                  BinarySceneArray& array) {
+  array.offset = contents.size();
+  array.count = records.size();
+  contents.insert(contents.end(), (const char*)records.data(),
+                  (const char*)(records.data() + records.size()));
+}
+
+/**
+ * @brief encodes a parsed scene as a binary scene
+ * shapes that share a material share its record, the shapes are grouped by
+ * kind, in the order they have in the scene
+ * @param contents set to the binary scene
+ * @return false if the machine is not little endian
+ */
+bool encode_binary_scene(const SceneDescription& scene,
+                         vector<char>& contents) {
+  if (!is_little_endian()) {
+    return false;
+  }
+  BinarySceneHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, BINARY_SCENE_MAGIC, sizeof(header.magic));
+  header.version = BINARY_SCENE_VERSION;
+  header.header_size = sizeof(BinarySceneHeader);
+  header.near_plane = scene.near_plane;
+  header.far_plane = scene.far_plane;
+  header.fov_y = scene.fov_y;
+  header.aspect_ratio = scene.aspect_ratio;
+  header.level_of_recursion = scene.level_of_recursion;
+  header.number_of_pixels_y = scene.number_of_pixels_y;
+  header.width_of_cell = scene.width_of_cell;
+  header.ambient_coefficient = scene.ambient_coefficient;
+  header.diffuse_coefficient = scene.diffuse_coefficient;
+  header.reflection_coefficient = scene.reflection_coefficient;
+
+  vector<BinaryMaterial> materials;
+  unordered_map<BinaryMaterial, uint32_t, BinaryMaterialHash,
+                BinaryMaterialEqual>
+      material_index;
+  material_index.reserve(scene.shapes.size());
+  vector<BinarySphere> spheres;
+  vector<BinaryCube> cubes;
+  vector<BinaryPyramid> pyramids;
+  for (const ShapeDescription& shape : scene.shapes) {
+    BinaryMaterial record = {{shape.color[0], shape.color[1], shape.color[2]},
+                             shape.shine,
+                             shape.ambient,
+                             shape.diffuse,
+                             shape.specular,
+                             shape.reflection};
+    auto inserted = material_index.emplace(record, materials.size());
+    uint32_t material = inserted.first->second;
+    if (inserted.second) {
+      materials.push_back(record);
+    }
+
+    const double* p = shape.position;
+    if (shape.type == SHAPE_SPHERE) {
+      BinarySphere sphere = {{p[0], p[1], p[2]}, shape.size[0], material, 0};
+      spheres.push_back(sphere);
+    } else if (shape.type == SHAPE_CUBE) {
+      BinaryCube cube = {{p[0], p[1], p[2]}, shape.size[0], material, 0};
+      cubes.push_back(cube);
+    } else if (shape.type == SHAPE_PYRAMID) {
+      BinaryPyramid pyramid = {{p[0], p[1], p[2]}, shape.size[0],
+                               shape.size[1], material, 0};
+      pyramids.push_back(pyramid);
+    }
+  }
+  vector<BinaryLight> lights;
+  for (const LightDescription& light : scene.lights) {
+    BinaryLight record;
+    memcpy(record.position, light.position, sizeof(record.position));
+    record.falloff = light.falloff;
+    lights.push_back(record);
+  }
+  vector<BinarySpotLight> spot_lights;
+  for (const SpotLightDescription& light : scene.spot_lights) {
+    BinarySpotLight record;
+    memcpy(record.position, light.position, sizeof(record.position));
+    record.falloff = light.falloff;
+    memcpy(record.pointing, light.pointing, sizeof(record.pointing));
+    record.angle = light.angle;
+    spot_lights.push_back(record);
+  }
+
+  // every record is a multiple of 8 bytes, so every array stays aligned
+  contents.assign(sizeof(BinarySceneHeader), 0);
+  append_array(contents, materials, header.materials);
+  append_array(contents, spheres, header.spheres);
+  append_array(contents, cubes, header.cubes);
+  append_array(contents, pyramids, header.pyramids);
+  append_array(contents, lights, header.lights);
+  append_array(contents, spot_lights, header.spot_lights);
+  memcpy(contents.data(), &header, sizeof(header));
+  return true;
+}
+
+/**
+ * @brief writes a parsed scene as a binary scene, see encode_binary_scene
+ * @return false if the file cannot be written
+ */
+bool write_binary_scene(const SceneDescription& scene, const string& filename) {
+  vector<char> contents;
+  return encode_binary_scene(scene, contents) &&
+         write_whole_file(filename, contents);
+}
+
+#endif  // BINARY_SCENE_H
@@ -393,13 +393,13 @@ class bitmap_image {
     }
   }
 
-  void save_image(const std::string& file_name) const {
+  bool save_image(const std::string& file_name) const {
     std::ofstream stream(file_name.c_str(), std::ios::binary);
 
     if (!stream) {
       std::cerr << "bitmap_image::save_image(): Error - Could not open file "
                 << file_name << " for writing!" << std::endl;
-      return;
+      return false;
     }
 
     bitmap_information_header bih;
@@ -441,6 +441,7 @@ class bitmap_image {
     }
 
     stream.close();
+    return !stream.fail();
   }
 
   inline void set_all_ith_bits_low(const unsigned int bitr_index) {
@@ -0,0 +1,1332 @@
+/**
+ * @file bvh.cpp
+ * @brief This file contains the bounding volume hierarchy over the shapes
+ * the hierarchy is built once after the scene is loaded and is then only read,
+ * so it can be shared by all the render threads. it is built as a binary tree
+ * and can be collapsed into a tree of 4 or 8 wide nodes, whose children are
+ * tested against a ray together (see wide_node.cpp). the wide nodes can be
+ * compressed further into quantized nodes a quarter of their size (see
+ * compressed_node.cpp). the binary tree is built top down, large subtrees in
+ * parallel on a task pool.
+ */
+
+#ifndef BVH_H
+#define BVH_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "1805086_aabb.cpp"
+#include "1805086_compressed_node.cpp"
+#include "1805086_line.cpp"
+#include "1805086_ray_packet.cpp"
+#include "1805086_shape.cpp"
+#include "1805086_task_pool.cpp"
+#include "1805086_wide_node.cpp"
+
+using namespace std;
+
+/**
+ * @brief how the primitives of a node are split between its children
+ */
+enum BVHBuild {
+  // at the median centroid along the longest axis, the fastest to build
+  BVH_BUILD_MEDIAN,
+  // where the surface area heuristic estimated over centroid bins is lowest,
+  // the fastest to traverse
+  BVH_BUILD_SAH
+};
+
+/**
+ * @brief The BVH class
+ * binary tree of bounding boxes stored depth first in a flat array, the left
+ * child of an interior node is the node right after it. a wide hierarchy
+ * keeps the leaves of the binary tree and replaces its interior nodes, every
+ * query gives the same hit for any width
+ */
+class BVH : public Accelerator {
+ private:
+  /**
+   * @brief a node of the tree
+   * leaves have count > 0 and hold the primitives [offset, offset + count) of
+   * the index array, interior nodes have count == 0 and offset is the index of
+   * the right child
+   */
+  struct Node {
+    AABB box;
+    int offset;
+    int count;
+  };
+
+  /**
+   * @brief a child of a wide node waiting on the traversal stack
+   */
+  struct WideEntry {
+    int child;       // a wide node or the first primitive of a leaf
+    int count;       // primitives of a leaf, 0 for a wide node
+    double t_enter;  // where the ray enters the box of the child
+  };
+
+  /**
+   * @brief a child of a compressed node while the wide nodes are compressed
+   */
+  struct CompressedSlot {
+    AABB box;
+    int child;  // a wide node or the first primitive of a leaf
+    int count;  // primitives of a leaf, 0 for a wide node
+  };
+
+  /**
+   * @brief boxes merged into one and counted, the primitives whose centroid
+   * falls into a slab of the centroid bounds of a node
+   */
+  struct Bin {
+    Double4 low;   // of the boxes, x y z and an unused lane
+    Double4 high;
+    int count;
+
+    Bin() : low(INFINITY), high(-INFINITY), count(0) {}
+
+    void expand(const Bin& bin) {
+      low = min(low, bin.low);
+      high = max(high, bin.high);
+      count += bin.count;
+    }
+
+    AABB getBox() const {
+      double corners[2][4];
+      low.store(corners[0]);
+      high.store(corners[1]);
+      AABB box;
+      for (int axis = 0; axis < 3; axis++) {
+        box.low[axis] = corners[0][axis];
+        box.high[axis] = corners[1][axis];
+      }
+      return box;
+    }
+  };
+
+  /**
+   * @brief a primitive while the tree is built, the references of a node are
+   * kept next to each other so that binning reads memory in order. the
+   * vectors have a fourth lane so that they load as one Double4
+   */
+  struct Reference {
+    double low[4];
+    double high[4];
+    double centroid[4];
+    int index;
+  };
+
+  // deepest tree the traversal stack can hold
+  static const int MAX_DEPTH = 64;
+  // bins per axis of the surface area heuristic
+  static const int NUMBER_OF_BINS = 16;
+  // subtrees with fewer primitives are built by the thread that splits them
+  static const int PARALLEL_SUBTREE = 4096;
+  // the primitives of a node are binned in chunks of this many in parallel
+  static const int PARALLEL_CHUNK = 32768;
+
+  vector<Shape*> primitives;  // the shapes, in the order they were given
+  vector<ShapeType> types;    // kind of each primitive, for the statistics
+  vector<int> indices;        // primitive indices ordered by leaf
+  vector<Reference> references;  // of each primitive, only while building
+  vector<Node> nodes;  // the binary tree, empty once it is collapsed
+  vector<WideNode<4>> nodes4;
+  vector<WideNode<8>> nodes8;
+  vector<CompressedNode<4>> compressed4;
+  vector<CompressedNode<8>> compressed8;
+  int max_leaf_size;
+  int width;  // of the nodes that are traversed: 2, 4 or 8
+  bool compressed;  // the wide nodes are CompressedNodes
+  BVHBuild build_mode;
+  double sah_cost;
+
+  /**
+   * @brief call function(chunk, begin, end) for the chunks of
+   * PARALLEL_CHUNK indices of [first, last), on the pool if there is one
+   * @return the number of chunks
+   */
+  template <typename Function>
+  int forChunks(int first, int last, TaskPool* pool, Function function) {
+    int chunks = (last - first + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+    if (pool == NULL || chunks < 2) {
+      for (int chunk = 0; chunk < chunks; chunk++) {
+        function(chunk, first + chunk * PARALLEL_CHUNK,
+                 min(last, first + (chunk + 1) * PARALLEL_CHUNK));
+      }
+      return chunks;
+    }
+    atomic<int> pending(chunks);
+    for (int chunk = 0; chunk < chunks; chunk++) {
+      pool->submit([&, chunk]() {
+        function(chunk, first + chunk * PARALLEL_CHUNK,
+                 min(last, first + (chunk + 1) * PARALLEL_CHUNK));
+        pending--;
+      });
+    }
+    pool->wait(pending);
+    return chunks;
+  }
+
+  /**
+   * @brief merge the boxes and the centroids of [first, last) into bounds
+   */
+  void boundPrimitives(int first, int last, Bin& bounds, Bin& centroid_bounds) {
+    for (int i = first; i < last; i++) {
+      const Reference& reference = references[i];
+      Double4 centroid = Double4::load(reference.centroid);
+      bounds.low = min(bounds.low, Double4::load(reference.low));
+      bounds.high = max(bounds.high, Double4::load(reference.high));
+      centroid_bounds.low = min(centroid_bounds.low, centroid);
+      centroid_bounds.high = max(centroid_bounds.high, centroid);
+    }
+  }
+
+  /**
+   * @brief the bounds of the boxes and of the centroids of [first, last)
+   * the chunks are merged in order, so the result does not depend on the
+   * number of threads
+   */
+  void computeBounds(int first,
+                     int last,
+                     TaskPool* pool,
+                     AABB& box,
+                     AABB& centroid_box) {
+    Bin bounds, centroid_bounds;
+    if (pool == NULL || last - first <= PARALLEL_CHUNK) {
+      boundPrimitives(first, last, bounds, centroid_bounds);
+    } else {
+      vector<Bin> chunk_bounds((last - first) / PARALLEL_CHUNK + 1);
+      vector<Bin> chunk_centroid_bounds(chunk_bounds.size());
+      int chunks = forChunks(first, last, pool, [&](int chunk, int begin,
+                                                    int end) {
+        boundPrimitives(begin, end, chunk_bounds[chunk],
+                        chunk_centroid_bounds[chunk]);
+      });
+      for (int chunk = 0; chunk < chunks; chunk++) {
+        bounds.expand(chunk_bounds[chunk]);
+        centroid_bounds.expand(chunk_centroid_bounds[chunk]);
+      }
+    }
+    box = bounds.getBox();
+    centroid_box = centroid_bounds.getBox();
+  }
+
+  /**
+   * @brief the bin of a primitive along an axis of the centroid bounds
+   * @param scale the number of bins over the extent of the centroid bounds
+   */
+  static int getBin(const double centroid[4],
+                    const AABB& centroid_box,
+                    double scale,
+                    int number_of_bins,
+                    int axis) {
+    int bin = (int)((centroid[axis] - centroid_box.low[axis]) * scale);
+    return max(0, min(number_of_bins - 1, bin));
+  }
+
+  typedef Bin Bins[3][NUMBER_OF_BINS];
+
+  /**
+   * @brief sort the primitives of [first, last) into the bins of every axis
+   * along which the centroid bounds have an extent
+   * @param scale the number of bins over the extent along each axis, 0 if
+   * there is none
+   */
+  void binPrimitives(int first,
+                     int last,
+                     const AABB& centroid_box,
+                     const double scale[3],
+                     int number_of_bins,
+                     Bins& bins) {
+    for (int a = 0; a < 3; a++) {
+      for (int b = 0; b < number_of_bins; b++) {
+        bins[a][b] = Bin();
+      }
+    }
+    for (int i = first; i < last; i++) {
+      const Reference& reference = references[i];
+      Double4 low = Double4::load(reference.low);
+      Double4 high = Double4::load(reference.high);
+      for (int a = 0; a < 3; a++) {
+        if (scale[a] != 0) {
+          Bin& bin = bins[a][getBin(reference.centroid, centroid_box,
+                                    scale[a], number_of_bins, a)];
+          bin.low = min(bin.low, low);
+          bin.high = max(bin.high, high);
+          bin.count++;
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief find the split of [first, last) between two bins with the lowest
+   * surface area heuristic, the cost of a child is its surface area times
+   * its number of primitives. a node gets at most one bin per primitive
+   * @param axis set to the axis of the split
+   * @param scale set to the number of bins over the extent along the axis
+   * @param split set to the first bin of the right child
+   * @param number_of_bins set to the number of bins along the axis
+   * @return false if no split leaves primitives on both sides
+   */
+  bool findSplit(int first,
+                 int last,
+                 TaskPool* pool,
+                 const AABB& centroid_box,
+                 int& axis,
+                 double& scale,
+                 int& split,
+                 int& number_of_bins) {
+    number_of_bins = min(NUMBER_OF_BINS, last - first);
+    double scales[3];
+    for (int a = 0; a < 3; a++) {
+      double extent = centroid_box.high[a] - centroid_box.low[a];
+      scales[a] = extent > 0 ? number_of_bins / extent : 0;
+    }
+    Bins bins;
+    if (pool == NULL || last - first <= PARALLEL_CHUNK) {
+      binPrimitives(first, last, centroid_box, scales, number_of_bins, bins);
+    } else {
+      vector<Bins> chunk_bins((last - first) / PARALLEL_CHUNK + 1);
+      int chunks = forChunks(first, last, pool, [&](int chunk, int begin,
+                                                    int end) {
+        binPrimitives(begin, end, centroid_box, scales, number_of_bins,
+                      chunk_bins[chunk]);
+      });
+      for (int a = 0; a < 3; a++) {
+        for (int b = 0; b < number_of_bins; b++) {
+          bins[a][b] = Bin();
+          for (int chunk = 0; chunk < chunks; chunk++) {
+            bins[a][b].expand(chunk_bins[chunk][a][b]);
+          }
+        }
+      }
+    }
+
+    double best_cost = INFINITY;
+    for (int a = 0; a < 3; a++) {
+      if (scales[a] == 0) {
+        continue;
+      }
+      // the cost of the left side of every split, then sweep from the right
+      double left_cost[NUMBER_OF_BINS];
+      int left_count[NUMBER_OF_BINS];
+      Bin left;
+      for (int b = 0; b < number_of_bins - 1; b++) {
+        left.expand(bins[a][b]);
+        left_count[b] = left.count;
+        left_cost[b] = left.getBox().surfaceArea() * left.count;
+      }
+      Bin right;
+      for (int b = number_of_bins - 1; b > 0; b--) {
+        right.expand(bins[a][b]);
+        int count = right.count;
+        double cost = left_cost[b - 1] + right.getBox().surfaceArea() * count;
+        if (left_count[b - 1] > 0 && count > 0 && cost < best_cost) {
+          best_cost = cost;
+          axis = a;
+          split = b;
+        }
+      }
+    }
+    if (best_cost == INFINITY) {
+      return false;
+    }
+    scale = scales[axis];
+    return true;
+  }
+
+  /**
+   * @brief reorder [first, last) so that the primitives of the left child
+   * come first
+   * @return the first primitive of the right child
+   */
+  int partitionPrimitives(int first,
+                          int last,
+                          TaskPool* pool,
+                          const AABB& centroid_box) {
+    int axis, split, number_of_bins;
+    double scale;
+    if (build_mode == BVH_BUILD_SAH &&
+        findSplit(first, last, pool, centroid_box, axis, scale, split,
+                  number_of_bins)) {
+      return partition(references.begin() + first,
+                       references.begin() + last,
+                       [&](const Reference& reference) {
+                         return getBin(reference.centroid, centroid_box,
+                                       scale, number_of_bins, axis) < split;
+                       }) -
+             references.begin();
+    }
+
+    axis = centroid_box.longestAxis();
+    int middle = first + (last - first) / 2;
+    nth_element(references.begin() + first, references.begin() + middle,
+                references.begin() + last,
+                [&](const Reference& a, const Reference& b) {
+                  return a.centroid[axis] < b.centroid[axis];
+                });
+    return middle;
+  }
+
+  /**
+   * @brief build the subtree over references [first, last) and return its
+   * root. the nodes are appended to tree depth first. the right subtree of a
+   * large node is built by another thread of the pool into an array of its
+   * own, which is appended once the left subtree is done
+   */
+  int build(int first,
+            int last,
+            int depth,
+            vector<Node>& tree,
+            TaskPool* pool) {
+    int node_index = tree.size();
+    tree.push_back(Node());
+
+    AABB box;
+    AABB centroid_box;
+    computeBounds(first, last, pool, box, centroid_box);
+    tree[node_index].box = box;
+
+    int count = last - first;
+    int axis = centroid_box.longestAxis();
+    if (count <= max_leaf_size || depth >= MAX_DEPTH - 1 ||
+        centroid_box.high[axis] <= centroid_box.low[axis]) {
+      tree[node_index].offset = first;
+      tree[node_index].count = count;
+      return node_index;
+    }
+
+    int middle = partitionPrimitives(first, last, pool, centroid_box);
+    int right;
+    if (pool != NULL && count >= PARALLEL_SUBTREE) {
+      vector<Node> right_tree;
+      atomic<int> pending(1);
+      pool->submit([&]() {
+        build(middle, last, depth + 1, right_tree, pool);
+        pending--;
+      });
+      build(first, middle, depth + 1, tree, pool);
+      pool->wait(pending);
+      right = tree.size();
+      for (Node node : right_tree) {
+        if (node.count == 0) {
+          node.offset += right;
+        }
+        tree.push_back(node);
+      }
+    } else {
+      build(first, middle, depth + 1, tree, pool);
+      right = build(middle, last, depth + 1, tree, pool);
+    }
+    tree[node_index].offset = right;
+    tree[node_index].count = 0;
+    return node_index;
+  }
+
+  /**
+   * @brief the surface area heuristic of the binary tree: the expected
+   * number of nodes visited and primitives tested by a ray that hits the
+   * root, with both counted the same
+   */
+  double computeSAHCost() {
+    double root_area = nodes[0].box.surfaceArea();
+    if (root_area <= 0) {
+      return nodes[0].count;
+    }
+    double cost = 0;
+    for (const Node& node : nodes) {
+      cost += node.box.surfaceArea() / root_area *
+              (node.count > 0 ? node.count : 1);
+    }
+    return cost;
+  }
+
+  /**
+   * @brief whether a leaf lies inside the index array
+   */
+  bool isLeafValid(int offset, int count) {
+    return offset >= 0 && offset <= (int)indices.size() &&
+           count <= (int)indices.size() - offset;
+  }
+
+  /**
+   * @brief whether binary nodes that were read back form a tree over the
+   * primitives. children come after their parent, so there is no cycle, and
+   * no leaf is deeper than the traversal stacks allow
+   */
+  bool isTreeValid(const vector<Node>& tree) {
+    vector<int> depth(tree.size(), 0);
+    for (int i = 0; i < tree.size(); i++) {
+      const Node& node = tree[i];
+      if (node.count > 0) {
+        if (!isLeafValid(node.offset, node.count)) {
+          return false;
+        }
+        continue;
+      }
+      int children[2] = {i + 1, node.offset};
+      for (int child : children) {
+        if (node.count < 0 || child <= i || child >= (int)tree.size() ||
+            depth[i] + 1 >= MAX_DEPTH) {
+          return false;
+        }
+        depth[child] = max(depth[child], depth[i] + 1);
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief whether wide or compressed nodes that were read back form a tree
+   * over the primitives, see isTreeValid(const vector<Node>&)
+   */
+  template <typename NodeType>
+  bool isTreeValid(const vector<NodeType>& tree) {
+    const int WIDTH = NodeType::SLOTS;
+    vector<int> depth(tree.size(), 0);
+    for (int i = 0; i < tree.size(); i++) {
+      const NodeType& node = tree[i];
+      if (node.size < 1 || node.size > WIDTH) {
+        return false;
+      }
+      int children[WIDTH], counts[WIDTH];
+      node.getChildren(children, counts);
+      for (int slot = 0; slot < node.size; slot++) {
+        int child = children[slot];
+        if (counts[slot] > 0) {
+          if (!isLeafValid(child, counts[slot])) {
+            return false;
+          }
+        } else if (counts[slot] < 0 || child <= i ||
+                   child >= (int)tree.size() || depth[i] + 1 >= MAX_DEPTH) {
+          return false;
+        } else {
+          depth[child] = max(depth[child], depth[i] + 1);
+        }
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief copy nodes that were read back into the array of their layout
+   */
+  template <typename NodeType>
+  static void copyNodes(const char* data,
+                        int number_of_nodes,
+                        vector<NodeType>& tree) {
+    tree.resize(number_of_nodes);
+    memcpy((void*)tree.data(), data, number_of_nodes * sizeof(NodeType));
+  }
+
+  /**
+   * @brief origin and inverse direction of a line for the slab tests
+   */
+  static void prepareRay(Line& line,
+                         double origin[3],
+                         double inverse_direction[3]) {
+    Vector3D start = line.getStart();
+    Vector3D direction = line.getDirection();
+    for (int i = 0; i < 3; i++) {
+      origin[i] = start[i];
+      inverse_direction[i] = 1.0 / direction[i];
+    }
+  }
+
+  template <typename NodeType>
+  vector<NodeType>& getNodes() {
+    if constexpr (is_same<NodeType, WideNode<4>>::value) {
+      return nodes4;
+    } else if constexpr (is_same<NodeType, WideNode<8>>::value) {
+      return nodes8;
+    } else if constexpr (is_same<NodeType, CompressedNode<4>>::value) {
+      return compressed4;
+    } else {
+      return compressed8;
+    }
+  }
+
+  /**
+   * @brief collapse the binary subtree below an interior node into wide
+   * nodes and return the index of the top one
+   * the children of the binary node are opened, the one with the largest
+   * surface area first, until there are WIDTH of them or only leaves are left
+   */
+  template <int WIDTH>
+  int collapse(int binary_node) {
+    int children[WIDTH];
+    int size = 0;
+    children[size++] = binary_node + 1;
+    children[size++] = nodes[binary_node].offset;
+    while (size < WIDTH) {
+      int largest = -1;
+      for (int i = 0; i < size; i++) {
+        if (nodes[children[i]].count == 0 &&
+            (largest == -1 || nodes[children[i]].box.surfaceArea() >
+                                  nodes[children[largest]].box.surfaceArea())) {
+          largest = i;
+        }
+      }
+      if (largest == -1) {
+        break;
+      }
+      int opened = children[largest];
+      children[largest] = opened + 1;
+      children[size++] = nodes[opened].offset;
+    }
+
+    vector<WideNode<WIDTH>>& wide_nodes = getNodes<WideNode<WIDTH>>();
+    int node_index = wide_nodes.size();
+    wide_nodes.push_back(WideNode<WIDTH>());
+    for (int i = 0; i < size; i++) {
+      const Node& child = nodes[children[i]];
+      // the wide nodes can move while the subtree is collapsed
+      int child_index = child.count > 0 ? child.offset
+                                        : collapse<WIDTH>(children[i]);
+      wide_nodes[node_index].addChild(child.box, child_index, child.count);
+    }
+    return node_index;
+  }
+
+  /**
+   * @brief replace the binary tree with a tree of WIDTH wide nodes
+   */
+  template <int WIDTH>
+  void collapse() {
+    vector<WideNode<WIDTH>>& wide_nodes = getNodes<WideNode<WIDTH>>();
+    if (nodes[0].count > 0) {
+      // a root that is a leaf becomes the only child of a wide node
+      wide_nodes.push_back(WideNode<WIDTH>());
+      wide_nodes[0].addChild(nodes[0].box, nodes[0].offset, nodes[0].count);
+    } else {
+      collapse<WIDTH>(0);
+    }
+    vector<Node>().swap(nodes);
+  }
+
+  /**
+   * @brief the slots of a wide node
+   * @return the number of slots
+   */
+  template <int WIDTH>
+  static int getSlots(const WideNode<WIDTH>& node,
+                      CompressedSlot slots[WIDTH]) {
+    for (int i = 0; i < node.size; i++) {
+      slots[i] = {node.getBox(i), node.child[i], node.count[i]};
+    }
+    return node.size;
+  }
+
+  /**
+   * @brief write the compressed node of some slots to node_index and
+   * compress its node children after it
+   * the primitives of its leaves are appended to leaf_indices in slot order.
+   * a leaf with more primitives than a slot holds becomes a node child whose
+   * slots split it, each with the box of the whole leaf
+   */
+  template <int WIDTH>
+  void compress(const CompressedSlot* slots,
+                int size,
+                int node_index,
+                vector<int>& leaf_indices) {
+    vector<CompressedNode<WIDTH>>& compressed_nodes =
+        getNodes<CompressedNode<WIDTH>>();
+    AABB box;
+    for (int i = 0; i < size; i++) {
+      box.expand(slots[i].box);
+    }
+    CompressedNode<WIDTH> node;
+    node.setBox(box);
+    node.child = compressed_nodes.size();
+    node.primitive = leaf_indices.size();
+    int node_children = 0;
+    for (int i = 0; i < size; i++) {
+      const CompressedSlot& slot = slots[i];
+      if (slot.count > 0 && slot.count <= CompressedNode<WIDTH>::MAX_COUNT) {
+        node.addChild(slot.box, slot.count);
+        leaf_indices.insert(leaf_indices.end(), indices.begin() + slot.child,
+                            indices.begin() + slot.child + slot.count);
+      } else {
+        node.addChild(slot.box, 0);
+        node_children++;
+      }
+    }
+    compressed_nodes[node_index] = node;
+    compressed_nodes.resize(compressed_nodes.size() + node_children);
+
+    int next_child = node.child;
+    for (int i = 0; i < size; i++) {
+      const CompressedSlot& slot = slots[i];
+      CompressedSlot children[WIDTH];
+      int children_size = 0;
+      if (slot.count == 0) {
+        children_size =
+            getSlots(getNodes<WideNode<WIDTH>>()[slot.child], children);
+      } else if (slot.count > CompressedNode<WIDTH>::MAX_COUNT) {
+        for (int j = 0; j < WIDTH; j++) {
+          int begin = slot.child + (long)slot.count * j / WIDTH;
+          int end = slot.child + (long)slot.count * (j + 1) / WIDTH;
+          children[children_size++] = {slot.box, begin, end - begin};
+        }
+      } else {
+        continue;
+      }
+      compress<WIDTH>(children, children_size, next_child++, leaf_indices);
+    }
+  }
+
+  /**
+   * @brief replace the tree of WIDTH wide nodes with compressed nodes, the
+   * index array is reordered so that the leaves of a node are consecutive
+   */
+  template <int WIDTH>
+  void compress() {
+    vector<WideNode<WIDTH>>& wide_nodes = getNodes<WideNode<WIDTH>>();
+    CompressedSlot root[WIDTH];
+    int size = getSlots(wide_nodes[0], root);
+    vector<int> leaf_indices;
+    leaf_indices.reserve(indices.size());
+    getNodes<CompressedNode<WIDTH>>().resize(1);
+    compress<WIDTH>(root, size, 0, leaf_indices);
+    indices.swap(leaf_indices);
+    vector<WideNode<WIDTH>>().swap(wide_nodes);
+  }
+
+  /**
+   * @brief test the primitives [first, first + count) of the index array
+   * and keep the nearest hit, ties go to the lower primitive index
+   */
+  void closestHitInLeaf(Line& line,
+                        int first,
+                        int count,
+                        double& nearest_t,
+                        int& nearest_index,
+                        HitRecord& hit) {
+    for (int i = first; i < first + count; i++) {
+      int index = indices[i];
+      thread_statistics.intersection_tests[types[index]]++;
+      HitRecord other_hit;
+      if (primitives[index]->intersect(line, 0, INFINITY, other_hit) &&
+          (other_hit.t < nearest_t ||
+           (other_hit.t == nearest_t && nearest_index != -1 &&
+            index < nearest_index))) {
+        nearest_t = other_hit.t;
+        nearest_index = index;
+        hit = other_hit;
+      }
+    }
+  }
+
+  /**
+   * @brief closestHitInLeaf for every ray of a packet
+   */
+  void closestHitInLeaf(RayPacket& packet,
+                        int first,
+                        int count,
+                        double nearest_t[SIMD_WIDTH],
+                        int index[SIMD_WIDTH]) {
+    for (int i = first; i < first + count; i++) {
+      int primitive = indices[i];
+      double other_t[SIMD_WIDTH];
+      thread_statistics.intersection_tests[types[primitive]] += packet.size;
+      primitives[primitive]->getT(packet, other_t);
+      for (int j = 0; j < SIMD_WIDTH; j++) {
+        if (other_t[j] > 0 &&
+            (other_t[j] < nearest_t[j] ||
+             (other_t[j] == nearest_t[j] && index[j] != -1 &&
+              primitive < index[j]))) {
+          nearest_t[j] = other_t[j];
+          index[j] = primitive;
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief whether any of the primitives [first, first + count) of the
+   * index array is hit with 0 < t < t_max
+   */
+  bool occludedInLeaf(Line& line, int first, int count, double t_max) {
+    for (int i = first; i < first + count; i++) {
+      thread_statistics.intersection_tests[types[indices[i]]]++;
+      if (primitives[indices[i]]->occluded(line, t_max)) {
+        thread_statistics.occlusion_early_outs++;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief closestHitIndex over the wide nodes
+   * the children a ray enters are pushed farthest first, so the nearest one
+   * is visited next, a child is skipped if a nearer hit has been found since
+   */
+  template <typename NodeType>
+  int closestHitIndexWide(Line& line, double t_max, HitRecord& hit) {
+    const int WIDTH = NodeType::SLOTS;
+    vector<NodeType>& wide_nodes = getNodes<NodeType>();
+    double origin[3], inverse_direction[3];
+    prepareRay(line, origin, inverse_direction);
+    Double4 wide_origin[3], wide_inverse_direction[3];
+    for (int i = 0; i < 3; i++) {
+      wide_origin[i] = Double4(origin[i]);
+      wide_inverse_direction[i] = Double4(inverse_direction[i]);
+    }
+
+    int nearest_index = -1;
+    double nearest_t = t_max;
+    WideEntry stack[MAX_DEPTH * WIDTH];
+    int stack_size = 0;
+    stack[stack_size++] = {0, 0, 0};
+    while (stack_size > 0) {
+      WideEntry entry = stack[--stack_size];
+      if (entry.t_enter > nearest_t) {
+        continue;
+      }
+      if (entry.count > 0) {
+        closestHitInLeaf(line, entry.child, entry.count, nearest_t,
+                         nearest_index, hit);
+        continue;
+      }
+
+      const NodeType& node = wide_nodes[entry.child];
+      double t_enter[WIDTH];
+      int mask = node.intersect(wide_origin, wide_inverse_direction,
+                                nearest_t, t_enter);
+      int children[WIDTH], counts[WIDTH];
+      node.getChildren(children, counts);
+      // insert the children by decreasing distance above the stack
+      int first = stack_size;
+      for (int i = 0; i < WIDTH; i++) {
+        if ((mask >> i & 1) == 0) {
+          continue;
+        }
+        int j = stack_size++;
+        while (j > first && stack[j - 1].t_enter < t_enter[i]) {
+          stack[j] = stack[j - 1];
+          j--;
+        }
+        stack[j] = {children[i], counts[i], t_enter[i]};
+      }
+    }
+    return nearest_index;
+  }
+
+  /**
+   * @brief closestHitIndex of a packet over the wide nodes
+   * the stack holds slots of wide nodes, the box of a slot is tested when it
+   * is taken off the stack so that it sees the nearest hits found so far
+   */
+  template <typename NodeType>
+  void closestHitIndexWide(RayPacket& packet,
+                           int index[SIMD_WIDTH],
+                           double nearest_t[SIMD_WIDTH]) {
+    const int WIDTH = NodeType::SLOTS;
+    vector<NodeType>& wide_nodes = getNodes<NodeType>();
+    // node and slot of each entry
+    int stack[MAX_DEPTH * WIDTH][2];
+    int stack_size = 0;
+    for (int i = wide_nodes[0].size - 1; i >= 0; i--) {
+      stack[stack_size][0] = 0;
+      stack[stack_size++][1] = i;
+    }
+    while (stack_size > 0) {
+      stack_size--;
+      const NodeType& node = wide_nodes[stack[stack_size][0]];
+      int slot = stack[stack_size][1];
+      if (node.getBox(slot)
+              .intersect(packet, Double4::load(nearest_t))
+              .bits() == 0) {
+        continue;
+      }
+      int children[WIDTH], counts[WIDTH];
+      node.getChildren(children, counts);
+      if (counts[slot] > 0) {
+        closestHitInLeaf(packet, children[slot], counts[slot], nearest_t,
+                         index);
+        continue;
+      }
+      int child = children[slot];
+      for (int i = wide_nodes[child].size - 1; i >= 0; i--) {
+        stack[stack_size][0] = child;
+        stack[stack_size++][1] = i;
+      }
+    }
+  }
+
+  /**
+   * @brief occluded over the wide nodes
+   */
+  template <typename NodeType>
+  bool occludedWide(Line& line, double t_max) {
+    const int WIDTH = NodeType::SLOTS;
+    vector<NodeType>& wide_nodes = getNodes<NodeType>();
+    double origin[3], inverse_direction[3];
+    prepareRay(line, origin, inverse_direction);
+    Double4 wide_origin[3], wide_inverse_direction[3];
+    for (int i = 0; i < 3; i++) {
+      wide_origin[i] = Double4(origin[i]);
+      wide_inverse_direction[i] = Double4(inverse_direction[i]);
+    }
+
+    int stack[MAX_DEPTH * WIDTH];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0) {
+      const NodeType& node = wide_nodes[stack[--stack_size]];
+      double t_enter[WIDTH];
+      int mask = node.intersect(wide_origin, wide_inverse_direction, t_max,
+                                t_enter);
+      int children[WIDTH], counts[WIDTH];
+      node.getChildren(children, counts);
+      for (int i = 0; i < WIDTH; i++) {
+        if ((mask >> i & 1) == 0) {
+          continue;
+        }
+        if (counts[i] == 0) {
+          stack[stack_size++] = children[i];
+        } else if (occludedInLeaf(line, children[i], counts[i], t_max)) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+ public:
+  /**
+   * @brief empty hierarchy, nothing is ever hit
+   */
+  BVH()
+      : max_leaf_size(2),
+        width(2),
+        compressed(false),
+        build_mode(BVH_BUILD_SAH),
+        sah_cost(0) {}
+
+  /**
+   * @brief build the hierarchy over a list of shapes
+   * @param primitives the shapes, their order decides ties between hits at
+   * exactly the same distance (the lower index wins, as in a linear scan)
+   * @param max_leaf_size the maximum number of shapes in a leaf
+   * @param width the number of children of a node, 2, 4 or 8
+   * @param build_mode how the nodes are split
+   * @param number_of_threads the threads that build it, the tree is the same
+   * for any number
+   * @param compressed whether 4 and 8 wide nodes are compressed, every query
+   * still gives the same hit
+   */
+  BVH(vector<Shape*> primitives,
+      int max_leaf_size = 2,
+      int width = 2,
+      BVHBuild build_mode = BVH_BUILD_SAH,
+      int number_of_threads = 1,
+      bool compressed = false)
+      : primitives(primitives),
+        max_leaf_size(max_leaf_size),
+        width(width == 4 || width == 8 ? width : 2),
+        compressed(compressed && (width == 4 || width == 8)),
+        build_mode(build_mode),
+        sah_cost(0) {
+    int number_of_primitives = primitives.size();
+    types.resize(number_of_primitives);
+    references.resize(number_of_primitives);
+    indices.resize(number_of_primitives);
+    TaskPool* pool = NULL;
+    if (number_of_threads > 1 && number_of_primitives >= PARALLEL_SUBTREE) {
+      pool = new TaskPool(number_of_threads);
+    }
+    forChunks(0, number_of_primitives, pool, [&](int /*chunk*/, int begin,
+                                                 int end) {
+      for (int i = begin; i < end; i++) {
+        AABB box = this->primitives[i]->getBoundingBox();
+        // the shapes compute their hits with their own formulas, give the
+        // slab test some room for rounding
+        box.pad(1e-7 * (1 + box.magnitude()));
+        types[i] = this->primitives[i]->getType();
+        Reference& reference = references[i];
+        for (int axis = 0; axis < 4; axis++) {
+          reference.low[axis] = axis < 3 ? box.low[axis] : 0;
+          reference.high[axis] = axis < 3 ? box.high[axis] : 0;
+          reference.centroid[axis] = axis < 3 ? box.centroid(axis) : 0;
+        }
+        reference.index = i;
+      }
+    });
+    if (!primitives.empty()) {
+      build(0, number_of_primitives, 0, nodes, pool);
+      for (int i = 0; i < number_of_primitives; i++) {
+        indices[i] = references[i].index;
+      }
+      sah_cost = computeSAHCost();
+      if (this->width == 4) {
+        collapse<4>();
+        if (this->compressed) {
+          compress<4>();
+        }
+      } else if (this->width == 8) {
+        collapse<8>();
+        if (this->compressed) {
+          compress<8>();
+        }
+      }
+    }
+    delete pool;
+    vector<Reference>().swap(references);
+  }
+
+  /**
+   * @brief find the nearest primitive hit by the line
+   * every primitive that is reached fills in its hit once, the nearest one
+   * is kept
+   * @param line the ray
+   * @param t_max only hits with 0 < t < t_max count
+   * @param hit filled with the nearest hit, if there is one
+   * @return the index of the primitive or -1 if nothing is hit
+   */
+  int closestHitIndex(Line& line, double t_max, HitRecord& hit) {
+    if (primitives.empty()) {
+      return -1;
+    }
+    if (width == 4) {
+      return compressed
+                 ? closestHitIndexWide<CompressedNode<4>>(line, t_max, hit)
+                 : closestHitIndexWide<WideNode<4>>(line, t_max, hit);
+    }
+    if (width == 8) {
+      return compressed
+                 ? closestHitIndexWide<CompressedNode<8>>(line, t_max, hit)
+                 : closestHitIndexWide<WideNode<8>>(line, t_max, hit);
+    }
+    double origin[3], inverse_direction[3];
+    prepareRay(line, origin, inverse_direction);
+
+    int nearest_index = -1;
+    double nearest_t = t_max;
+    int stack[MAX_DEPTH];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0) {
+      Node& node = nodes[stack[--stack_size]];
+      double t_enter;
+      if (!node.box.intersect(origin, inverse_direction, nearest_t, t_enter)) {
+        continue;
+      }
+      if (node.count > 0) {
+        closestHitInLeaf(line, node.offset, node.count, nearest_t,
+                         nearest_index, hit);
+        continue;
+      }
+
+      // visit the nearer child first so the search interval shrinks early
+      int left = &node - &nodes[0] + 1;
+      int right = node.offset;
+      double t_left, t_right;
+      bool hit_left = nodes[left].box.intersect(origin, inverse_direction,
+                                                nearest_t, t_left);
+      bool hit_right = nodes[right].box.intersect(origin, inverse_direction,
+                                                  nearest_t, t_right);
+      if (hit_left && hit_right) {
+        if (t_left < t_right) {
+          stack[stack_size++] = right;
+          stack[stack_size++] = left;
+        } else {
+          stack[stack_size++] = left;
+          stack[stack_size++] = right;
+        }
+      } else if (hit_left) {
+        stack[stack_size++] = left;
+      } else if (hit_right) {
+        stack[stack_size++] = right;
+      }
+    }
+
+    return nearest_index;
+  }
+
+  /**
+   * @overridden
+   * @brief find the nearest shape hit by the line
+   */
+  Shape* closestHit(Line& line, double t_max, HitRecord& hit) {
+    int index = closestHitIndex(line, t_max, hit);
+    if (index == -1) {
+      return NULL;
+    }
+    hit.shape = primitives[index];
+    return hit.shape;
+  }
+
+  /**
+   * @brief closestHitIndex for every ray of a packet
+   * a node is visited when any of the rays overlaps its box, every ray gets
+   * the same primitive and t as closestHitIndex would give it
+   * @param packet the rays
+   * @param index set to the primitive index (or -1) of every lane
+   * @param t set to the distance of the nearest hit of every lane
+   */
+  void closestHitIndex(RayPacket& packet,
+                       int index[SIMD_WIDTH],
+                       double t[SIMD_WIDTH]) {
+    double nearest_t[SIMD_WIDTH];
+    for (int i = 0; i < SIMD_WIDTH; i++) {
+      index[i] = -1;
+      nearest_t[i] = INFINITY;
+    }
+
+    if (primitives.empty()) {
+      // nothing is hit
+    } else if (width == 4 && compressed) {
+      closestHitIndexWide<CompressedNode<4>>(packet, index, nearest_t);
+    } else if (width == 4) {
+      closestHitIndexWide<WideNode<4>>(packet, index, nearest_t);
+    } else if (width == 8 && compressed) {
+      closestHitIndexWide<CompressedNode<8>>(packet, index, nearest_t);
+    } else if (width == 8) {
+      closestHitIndexWide<WideNode<8>>(packet, index, nearest_t);
+    } else {
+      int stack[MAX_DEPTH];
+      int stack_size = 0;
+      stack[stack_size++] = 0;
+      while (stack_size > 0) {
+        Node& node = nodes[stack[--stack_size]];
+        if (node.box.intersect(packet, Double4::load(nearest_t)).bits() ==
+            0) {
+          continue;
+        }
+        if (node.count > 0) {
+          closestHitInLeaf(packet, node.offset, node.count, nearest_t, index);
+          continue;
+        }
+        stack[stack_size++] = node.offset;
+        stack[stack_size++] = &node - &nodes[0] + 1;
+      }
+    }
+
+    for (int i = 0; i < SIMD_WIDTH; i++) {
+      t[i] = nearest_t[i];
+    }
+  }
+
+  /**
+   * @brief find the nearest shape hit by every ray of a packet
+   * @param packet the rays
+   * @param shape set to the nearest shape (or NULL) of every lane
+   * @param t set to the distance of the nearest hit of every lane
+   */
+  void closestHit(RayPacket& packet,
+                  Shape* shape[SIMD_WIDTH],
+                  double t[SIMD_WIDTH]) {
+    int index[SIMD_WIDTH];
+    closestHitIndex(packet, index, t);
+    for (int i = 0; i < SIMD_WIDTH; i++) {
+      shape[i] = index[i] == -1 ? NULL : primitives[index[i]];
+    }
+  }
+
+  /**
+   * @overridden
+   * @brief check if any shape is hit with 0 < t < t_max
+   * returns at the first hit, the nodes are not ordered by distance
+   */
+  bool occluded(Line& line, double t_max) {
+    if (primitives.empty()) {
+      return false;
+    }
+    if (width == 4) {
+      return compressed ? occludedWide<CompressedNode<4>>(line, t_max)
+                        : occludedWide<WideNode<4>>(line, t_max);
+    }
+    if (width == 8) {
+      return compressed ? occludedWide<CompressedNode<8>>(line, t_max)
+                        : occludedWide<WideNode<8>>(line, t_max);
+    }
+    double origin[3], inverse_direction[3];
+    prepareRay(line, origin, inverse_direction);
+
+    int stack[MAX_DEPTH];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0) {
+      Node& node = nodes[stack[--stack_size]];
+      double t_enter;
+      if (!node.box.intersect(origin, inverse_direction, t_max, t_enter)) {
+        continue;
+      }
+      if (node.count > 0) {
+        if (occludedInLeaf(line, node.offset, node.count, t_max)) {
+          return true;
+        }
+        continue;
+      }
+      stack[stack_size++] = node.offset;
+      stack[stack_size++] = &node - &nodes[0] + 1;
+    }
+    return false;
+  }
+
+  /**
+   * @brief replace the hierarchy with one that was built before over the
+   * same primitives in the same order and saved from getIndices() and
+   * getNodeData(), the build is skipped
+   * @param indices the primitive indices ordered by leaf
+   * @param node_data the nodes of the layout of the width, number_of_nodes
+   * times getNodeSize(width, compressed) bytes
+   * @return false, leaving the hierarchy empty, if the arrays do not form a
+   * hierarchy over the primitives
+   */
+  bool load(vector<Shape*> primitives,
+            int max_leaf_size,
+            int width,
+            bool compressed,
+            BVHBuild build_mode,
+            double sah_cost,
+            const int* indices,
+            int number_of_indices,
+            const char* node_data,
+            int number_of_nodes) {
+    *this = BVH();
+    this->primitives = primitives;
+    this->max_leaf_size = max_leaf_size;
+    this->width = width == 4 || width == 8 ? width : 2;
+    this->compressed = compressed && (width == 4 || width == 8);
+    this->build_mode = build_mode;
+    this->sah_cost = sah_cost;
+    bool valid = number_of_indices == (int)primitives.size() &&
+                 (number_of_nodes > 0) == !primitives.empty();
+    for (int i = 0; valid && i < number_of_indices; i++) {
+      valid = indices[i] >= 0 && indices[i] < number_of_indices;
+    }
+    if (valid) {
+      this->indices.assign(indices, indices + number_of_indices);
+      for (Shape* primitive : primitives) {
+        types.push_back(primitive->getType());
+      }
+      if (this->width == 4 && this->compressed) {
+        copyNodes(node_data, number_of_nodes, compressed4);
+        valid = isTreeValid(compressed4);
+      } else if (this->width == 4) {
+        copyNodes(node_data, number_of_nodes, nodes4);
+        valid = isTreeValid(nodes4);
+      } else if (this->width == 8 && this->compressed) {
+        copyNodes(node_data, number_of_nodes, compressed8);
+        valid = isTreeValid(compressed8);
+      } else if (this->width == 8) {
+        copyNodes(node_data, number_of_nodes, nodes8);
+        valid = isTreeValid(nodes8);
+      } else {
+        copyNodes(node_data, number_of_nodes, nodes);
+        valid = isTreeValid(nodes);
+      }
+    }
+    if (!valid) {
+      *this = BVH();
+    }
+    return valid;
+  }
+
+  /**
+   * @brief the primitive indices ordered by leaf, the leaves of the nodes
+   * refer to them
+   */
+  const vector<int>& getIndices() { return indices; }
+
+  /**
+   * @brief the nodes of the width that is traversed, getNodeCount() of
+   * getNodeSize(getWidth(), isCompressed()) bytes each
+   */
+  const char* getNodeData() {
+    if (width == 4 && compressed) {
+      return (const char*)compressed4.data();
+    }
+    if (width == 8 && compressed) {
+      return (const char*)compressed8.data();
+    }
+    if (width == 4) {
+      return (const char*)nodes4.data();
+    }
+    if (width == 8) {
+      return (const char*)nodes8.data();
+    }
+    return (const char*)nodes.data();
+  }
+
+  /**
+   * @brief the size of a node of a width, compressed or not
+   */
+  static size_t getNodeSize(int width, bool compressed) {
+    if (width == 4 && compressed) {
+      return sizeof(CompressedNode<4>);
+    }
+    if (width == 8 && compressed) {
+      return sizeof(CompressedNode<8>);
+    }
+    if (width == 4) {
+      return sizeof(WideNode<4>);
+    }
+    if (width == 8) {
+      return sizeof(WideNode<8>);
+    }
+    return sizeof(Node);
+  }
+
+  int getMaxLeafSize() { return max_leaf_size; }
+
+  BVHBuild getBuildMode() { return build_mode; }
+
+  /**
+   * @brief the number of nodes in the tree, of the width that is traversed
+   */
+  int getNodeCount() {
+    if (width == 4 && compressed) {
+      return compressed4.size();
+    }
+    if (width == 8 && compressed) {
+      return compressed8.size();
+    }
+    if (width == 4) {
+      return nodes4.size();
+    }
+    if (width == 8) {
+      return nodes8.size();
+    }
+    return nodes.size();
+  }
+
+  /**
+   * @brief the surface area heuristic of the binary tree the hierarchy was
+   * built as, lower is better
+   */
+  double getSAHCost() { return sah_cost; }
+
+  /**
+   * @brief the number of children of a node, 2, 4 or 8
+   */
+  int getWidth() { return width; }
+
+  /**
+   * @brief whether the 4 or 8 wide nodes are compressed
+   */
+  bool isCompressed() { return compressed; }
+
+  /**
+   * @brief the memory taken by the nodes
+   */
+  size_t getNodeBytes() {
+    return nodes.size() * sizeof(Node) +
+           nodes4.size() * sizeof(WideNode<4>) +
+           nodes8.size() * sizeof(WideNode<8>) +
+           compressed4.size() * sizeof(CompressedNode<4>) +
+           compressed8.size() * sizeof(CompressedNode<8>);
+  }
+};
+
+#endif  // BVH_H
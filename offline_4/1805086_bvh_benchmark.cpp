@@ -0,0 +1,211 @@
+/**
+ * @file bvh_benchmark.cpp
+ * @brief This file contains the bounding volume hierarchy benchmark
+ * builds the hierarchy of generated scenes of increasing size with median
+ * and surface area heuristic splits, nodes of width 2, 4 and 8 and full or
+ * compressed wide nodes, and traces the primary rays of a frame through each,
+ * one by one and in packets, and a shadow ray from every primary hit to a
+ * light. prints the build time, the surface area heuristic, the memory of the
+ * nodes and the rays per second as one JSON object per scene, split, width and
+ * layout, and exits with 1 if any of them finds a different hit than the
+ * binary median tree.
+ *
+ * g++ -O2 -DHEADLESS 1805086_bvh_benchmark.cpp -o bvh_benchmark -pthread
+ * ./bvh_benchmark [number of repetitions, default 3] [build threads,
+ * default all]
+ */
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "1805086_renderer.cpp"
+#include "1805086_scene_generator.cpp"
+
+using namespace std;
+
+/**
+ * @brief the best time of a number of repetitions in ms
+ */
+template <typename Function>
+double best_ms(int repetitions, Function function) {
+  double best = INFINITY;
+  for (int i = 0; i < repetitions; i++) {
+    auto start = chrono::steady_clock::now();
+    function();
+    auto end = chrono::steady_clock::now();
+    best = min(best, chrono::duration<double, milli>(end - start).count());
+  }
+  return best;
+}
+
+/**
+ * @brief what every ray of the frame found
+ */
+struct TraceResult {
+  vector<Shape*> single;
+  vector<double> single_t;
+  vector<Shape*> packet;
+  vector<double> packet_t;
+  vector<char> occluded;
+};
+
+/**
+ * @brief how one of the compared hierarchies is built
+ */
+struct BuildOptions {
+  BVHBuild build;
+  const char* name;
+  int width;
+  bool compressed;
+};
+
+double rays_per_second(size_t rays, double ms) { return rays / (ms / 1000); }
+
+int main(int argc, char** argv) {
+  int repetitions = argc > 1 ? max(1, atoi(argv[1])) : 3;
+  int sizes[] = {1000, 10000, 100000};
+  BuildOptions options[] = {
+      {BVH_BUILD_MEDIAN, "median", 2, false},
+      {BVH_BUILD_MEDIAN, "median", 4, false},
+      {BVH_BUILD_MEDIAN, "median", 4, true},
+      {BVH_BUILD_MEDIAN, "median", 8, false},
+      {BVH_BUILD_MEDIAN, "median", 8, true},
+      {BVH_BUILD_SAH, "sah", 2, false},
+      {BVH_BUILD_SAH, "sah", 4, false},
+      {BVH_BUILD_SAH, "sah", 4, true},
+      {BVH_BUILD_SAH, "sah", 8, false},
+      {BVH_BUILD_SAH, "sah", 8, true}};
+  int build_threads = argc > 2 ? max(1, atoi(argv[2])) : number_of_threads;
+  const int height = 180;
+
+  camera = Vector3D(100, 100, 100);
+  look = Vector3D(0, 0, 0);
+  up = Vector3D(0, 0, 1);
+  Vector3D light(0, 0, 150);
+
+  bool passed = true;
+  for (int number_of_shapes : sizes) {
+    int each = number_of_shapes / 3;
+    SceneGenerator generator(number_of_shapes, each, each,
+                             number_of_shapes - 2 * each, 8, 4);
+    ostringstream text;
+    generator.write(text, height, 3);
+    string scene_text = text.str();
+    SceneParser parser;
+    SceneDescription scene;
+    parser.parse(scene_text.data(), scene_text.data() + scene_text.size(),
+                 scene);
+    streambuf* console = cout.rdbuf(NULL);
+    clear_scene();
+    load_scene(scene);
+    cout.rdbuf(console);
+    cout.clear();
+
+    RayGenerator rays(camera, look, up, near_plane, fov_y, aspect_ratio,
+                      number_of_pixels_y);
+    int width = get_image_width();
+    vector<Line> lines;
+    for (int y = 0; y < number_of_pixels_y; y++) {
+      for (int x = 0; x < width; x++) {
+        lines.push_back(rays.getLine(x, y));
+      }
+    }
+
+    TraceResult reference;
+    for (const BuildOptions& option : options) {
+      BVH bvh;
+      double build_ms = best_ms(1, [&]() {
+        bvh = BVH(shapes, 2, option.width, option.build, build_threads,
+                  option.compressed);
+      });
+
+      TraceResult result;
+      result.single.resize(lines.size());
+      result.single_t.resize(lines.size());
+      result.packet.resize(lines.size());
+      result.packet_t.resize(lines.size());
+      result.occluded.resize(lines.size());
+
+      double single_ms = best_ms(repetitions, [&]() {
+        for (int i = 0; i < lines.size(); i++) {
+          HitRecord hit;
+          result.single[i] = bvh.closestHit(lines[i], INFINITY, hit);
+          result.single_t[i] = hit.t;
+        }
+      });
+
+      double packet_ms = best_ms(repetitions, [&]() {
+        for (int i = 0; i < lines.size(); i += SIMD_WIDTH) {
+          int count = min(SIMD_WIDTH, (int)lines.size() - i);
+          Line* line_pointers[SIMD_WIDTH];
+          for (int j = 0; j < count; j++) {
+            line_pointers[j] = &lines[i + j];
+          }
+          RayPacket packet(line_pointers, count);
+          Shape* shapes_hit[SIMD_WIDTH];
+          double t[SIMD_WIDTH];
+          bvh.closestHit(packet, shapes_hit, t);
+          for (int j = 0; j < count; j++) {
+            result.packet[i + j] = shapes_hit[j];
+            result.packet_t[i + j] = t[j];
+          }
+        }
+      });
+
+      // shadow rays start at the light, as in Shape::addLight
+      vector<Line> shadow_lines;
+      vector<double> shadow_t;
+      vector<int> shadow_pixel;
+      for (int i = 0; i < lines.size(); i++) {
+        if (result.single[i] != NULL) {
+          Vector3D point = lines[i].getPoint(result.single_t[i]);
+          Vector3D direction = point - light;
+          shadow_lines.push_back(Line(light, direction));
+          shadow_t.push_back(direction.length() - 0.0001);
+          shadow_pixel.push_back(i);
+        }
+      }
+      double shadow_ms = best_ms(repetitions, [&]() {
+        for (int i = 0; i < shadow_lines.size(); i++) {
+          result.occluded[shadow_pixel[i]] =
+              bvh.occluded(shadow_lines[i], shadow_t[i]);
+        }
+      });
+
+      bool same = true;
+      if (&option == &options[0]) {
+        reference = result;
+      } else {
+        same = result.single == reference.single &&
+               result.single_t == reference.single_t &&
+               result.packet == reference.packet &&
+               result.packet_t == reference.packet_t &&
+               result.occluded == reference.occluded;
+      }
+      passed = passed && same;
+
+      cout << "{\"shapes\": " << number_of_shapes
+           << ", \"bvh_build\": \"" << option.name << "\""
+           << ", \"bvh_width\": " << option.width
+           << ", \"bvh_nodes\": \""
+           << (bvh.isCompressed() ? "compressed" : "full") << "\""
+           << ", \"sah_cost\": " << bvh.getSAHCost()
+           << ", \"nodes\": " << bvh.getNodeCount()
+           << ", \"node_bytes\": " << bvh.getNodeBytes()
+           << ", \"build_ms\": " << build_ms
+           << ", \"single_rays_per_second\": "
+           << rays_per_second(lines.size(), single_ms)
+           << ", \"packet_rays_per_second\": "
+           << rays_per_second(lines.size(), packet_ms)
+           << ", \"shadow_rays_per_second\": "
+           << rays_per_second(shadow_lines.size(), shadow_ms)
+           << ", \"same_hits\": " << (same ? "true" : "false") << "}"
+           << endl;
+    }
+  }
+  clear_scene();
+  return passed ? 0 : 1;
+}
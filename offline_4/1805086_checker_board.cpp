@@ -6,7 +6,9 @@
 #ifndef CHECKER_BOARD_H
 #define CHECKER_BOARD_H
 
+#ifndef HEADLESS
 #include <GL/glut.h>  // GLUT, includes glu.h and gl.h
+#endif
 
 #include "1805086_bitmap_image.hpp"
 #include "1805086_line.cpp"
@@ -37,7 +39,7 @@ class CheckerBoard : public Shape {
               color,
               ambient_coefficient,
               diffuse_coefficient,
-              0,
+              specular_coefficient,
               reflection_coefficient,
               1),
         width(width),
@@ -55,27 +57,12 @@ class CheckerBoard : public Shape {
   CheckerBoard()
       : Shape(), normal(Vector3D(0, 0, 1)), width(0), number_of_squares(0) {}
 
-  /**
-   * @overridden
-   * @brief returns the normal vector of the checker board
-   * @param intersection_point the point of intersection
-   * @param line the incident line
-   */
-  Line getNormal(Vector3D& intersection_point, Line line) {
-    // check on the direction of the line
-    // if the line is going away from the checker board, then the normal vector
-    // should be reversed
-    if (line.getDirection().dot_product(normal) > 0) {
-      return Line(intersection_point, normal * (-1));
-    }
-    return Line(intersection_point, normal);
-  }
-
   /**
    * @overridden
    * @brief draw the checker board
    */
   void draw() {
+#ifndef HEADLESS
     {
       // set the color of the checker board
 
@@ -118,6 +105,7 @@ class CheckerBoard : public Shape {
       // cout<< "done" << endl;
       // glutPostRedisplay();
     }
+#endif
   }
 
   /**
@@ -157,18 +145,106 @@ class CheckerBoard : public Shape {
     return t;
   }
 
+  /**
+   * @overridden
+   * @brief fills in the hit of the line with the checker board
+   * u and v are the offsets of the point from the position along x and y
+   */
+  bool intersect(Line& line, double t_min, double t_max, HitRecord& hit) {
+    double t = getT(line);
+    if (!(t > t_min && t < t_max)) {
+      return false;
+    }
+    hit.t = t;
+    hit.point = line.getPoint(t);
+    hit.normal = normal;
+    hit.two_sided = true;
+    hit.primitive = -1;
+    hit.u = hit.point[0] - position[0];
+    hit.v = hit.point[1] - position[1];
+    return true;
+  }
+
+  /**
+   * @overridden
+   * @brief getT for a packet of rays, the same arithmetic as getT done on
+   * every lane at once
+   * @param packet the rays
+   * @param t set to the distance of the hit (or -1) of every lane
+   */
+  void getT(RayPacket& packet, double t[SIMD_WIDTH]) {
+    Double4 dot_product = packet.getDirection(0) * Double4(normal[0]) +
+                          packet.getDirection(1) * Double4(normal[1]) +
+                          packet.getDirection(2) * Double4(normal[2]);
+    Double4 start_dot_normal = packet.getOrigin(0) * Double4(normal[0]) +
+                               packet.getOrigin(1) * Double4(normal[1]) +
+                               packet.getOrigin(2) * Double4(normal[2]);
+    Double4 t_hit = Double4(-1.0) * start_dot_normal / dot_product;
+
+    // getT truncates (point - position) / width towards zero and accepts
+    // -number_of_squares + 1 <= i < number_of_squares, that is the open
+    // interval -number_of_squares < (point - position) / width <
+    // number_of_squares
+    Double4 low(-number_of_squares);
+    Double4 high(number_of_squares);
+    Mask4 hit = (dot_product <= Double4(-0.000001)) |
+                (Double4(0.000001) <= dot_product);
+    for (int k = 0; k < 2; k++) {
+      Double4 point = packet.getOrigin(k) + packet.getDirection(k) * t_hit;
+      Double4 square = (point - Double4(position[k])) / Double4(width);
+      hit = hit & (low < square) & (square < high);
+    }
+    select(hit, t_hit, Double4(-1.0)).store(t);
+  }
+
+  /**
+   * @overridden
+   * @brief returns the kind of the shape
+   */
+  ShapeType getType() { return SHAPE_CHECKER_BOARD; }
+
+  /**
+   * @overridden
+   * @brief returns the bounding box of the checker board
+   * getT only accepts the squares i, j in [-number_of_squares + 1,
+   * number_of_squares), with i, j truncated towards zero that is the open
+   * interval (-number_of_squares, number_of_squares) widths around position
+   */
+  AABB getBoundingBox() {
+    double half_extent = number_of_squares * width;
+    return AABB(position - Vector3D(half_extent, half_extent, 0),
+                position + Vector3D(half_extent, half_extent, 0));
+  }
+
   /**
    * @overridden
    * @brief returns the color of the checker board at the point of intersection
    * @param intersection_point the point of intersection
    */
   Color getColorAt(Vector3D& intersection_point) {
+    return getColorAt(intersection_point[0] - position[0],
+                      intersection_point[1] - position[1]);
+  }
+
+  /**
+   * @overridden
+   * @brief returns the color of the checker board at a hit, from the offsets
+   * stored in the hit record
+   */
+  Color getColorAt(HitRecord& hit) { return getColorAt(hit.u, hit.v); }
+
+  /**
+   * @brief returns the color of the checker board at an offset from position
+   * @param u the offset along x
+   * @param v the offset along y
+   */
+  Color getColorAt(double u, double v) {
     // find the color of the square
-    int i = floor((intersection_point[0] - position[0]) / width);
-    int j = floor((intersection_point[1] - position[1]) / width);
+    int i = floor(u / width);
+    int j = floor(v / width);
     if (texture_mode) {
-      double x = (intersection_point[0] - position[0]) - width * i;
-      double y = (intersection_point[1] - position[1]) - width * j;
+      double x = u - width * i;
+      double y = v - width * j;
 
       int texture_x;
       int texture_y;
@@ -12,15 +12,17 @@ using namespace std;
 
 /**
  * @brief The Color class
+ * the channels are stored inline, so the class is trivially copyable and
+ * temporaries never touch the heap
  */
 class Color {
-  vector<double> v;
+  double v[3];
 
  public:
   /**
    * @brief Color
    */
-  Color() : v(3) {}
+  Color() : v{0, 0, 0} {}
 
   /**
    * @brief Color
@@ -28,31 +30,22 @@ class Color {
    * @param g
    * @param b
    */
-  Color(double r, double g, double b) : v(3) {
-    v[0] = r;
-    v[1] = g;
-    v[2] = b;
-  }
+  Color(double r, double g, double b) : v{r, g, b} {}
 
   /**
    * @brief operator []
    * @param index
    * @return
    */
-  double& operator[](int index) {
-    if (index < 0 || index > 2) {
-      cout << "Color: index out of bounds" << endl;
-      exit(1);
-    }
-    return v[index];
-  }
+  double& operator[](int index) { return v[index]; }
+  const double& operator[](int index) const { return v[index]; }
 
   /**
    * @brief operator *
    * @param c
    * @return upodated color
    */
-  Color operator*(double c) {
+  Color operator*(double c) const {
     Color color;
     for (int i = 0; i < 3; i++) {
       color[i] = v[i] * c;
@@ -65,7 +58,7 @@ class Color {
    * @param another_color
    * @return updated color
    */
-  Color operator*(Color another_color) {
+  Color operator*(const Color& another_color) const {
     Color color;
     for (int i = 0; i < 3; i++) {
       color[i] = v[i] * another_color[i];
@@ -78,7 +71,7 @@ class Color {
    * @param another_color
    * @return updated color
    */
-  Color operator+(Color another_color) {
+  Color operator+(const Color& another_color) const {
     Color color;
     for (int i = 0; i < 3; i++) {
       color[i] = v[i] + another_color[i];
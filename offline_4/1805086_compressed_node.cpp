@@ -0,0 +1,199 @@
+/**
+ * @file compressed_node.cpp
+ * @brief This file contains the quantized node of a wide bounding volume
+ * hierarchy
+ * a compressed node stores the boxes of its children as bytes on a grid laid
+ * over its own box, one power of two step per axis, and finds its children
+ * through two base indices instead of one per slot. a 4 wide node fits in one
+ * cache line and an 8 wide one in two, a quarter of a WideNode.
+ */
+
+#ifndef COMPRESSED_NODE_H
+#define COMPRESSED_NODE_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "1805086_aabb.cpp"
+#include "1805086_simd.cpp"
+
+using namespace std;
+
+/**
+ * @brief 2 to the power of an exponent in [-1022, 1023]
+ */
+inline double power_of_two(int exponent) {
+  uint64_t bits = (uint64_t)(exponent + 1023) << 52;
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/**
+ * @brief The CompressedNode struct
+ * a child is either another compressed node (count == 0) or a leaf of count
+ * primitives. the node children are the nodes [child, child + k) in slot
+ * order and the leaves take their primitives one after another from
+ * primitive in the index array. a child box is
+ * origin + [low, high] * 2^exponent, which always contains the box it was
+ * quantized from. the slots [size, WIDTH) are empty
+ */
+template <int WIDTH>
+struct alignas(64) CompressedNode {
+  static_assert(WIDTH % SIMD_WIDTH == 0, "a node is a whole number of Double4");
+
+  static const int SLOTS = WIDTH;
+  // the most primitives a leaf slot holds
+  static const int MAX_COUNT = 255;
+
+  double origin[3];
+  int child;
+  int primitive;
+  signed char exponent[3];
+  unsigned char size;
+  unsigned char count[WIDTH];
+  unsigned char low[3][WIDTH];
+  unsigned char high[3][WIDTH];
+
+  CompressedNode() : child(0), primitive(0), size(0) {
+    for (int axis = 0; axis < 3; axis++) {
+      origin[axis] = 0;
+      exponent[axis] = 0;
+    }
+    for (int i = 0; i < WIDTH; i++) {
+      count[i] = 0;
+      for (int axis = 0; axis < 3; axis++) {
+        low[axis][i] = 0;
+        high[axis][i] = 0;
+      }
+    }
+  }
+
+  /**
+   * @brief the grid of the node, box must hold every child box and be finite
+   * the step is the smallest power of two that spans the box in 255 steps.
+   * an axis on which the box is flat, such as the plane of coplanar
+   * triangles, gets the finest step so that the children stay flat on it
+   */
+  void setBox(const AABB& box) {
+    for (int axis = 0; axis < 3; axis++) {
+      origin[axis] = box.low[axis];
+      double extent = box.high[axis] - box.low[axis];
+      int step = -128;
+      if (extent > 0) {
+        frexp(extent / 255, &step);
+        step = max(step, -128);
+      }
+      while (step < 127 &&
+             origin[axis] + 255 * power_of_two(step) < box.high[axis]) {
+        step++;
+      }
+      exponent[axis] = step;
+    }
+  }
+
+  /**
+   * @brief fill the next empty slot, rounding the box outwards to the grid
+   * @param count 0 for a node child, otherwise the primitives of a leaf
+   */
+  void addChild(const AABB& box, int count) {
+    for (int axis = 0; axis < 3; axis++) {
+      double step = power_of_two(exponent[axis]);
+      double low_step = floor((box.low[axis] - origin[axis]) / step);
+      double high_step = ceil((box.high[axis] - origin[axis]) / step);
+      int low_value = (int)max(0.0, min(255.0, low_step));
+      int high_value = (int)max(0.0, min(255.0, high_step));
+      while (low_value > 0 &&
+             origin[axis] + low_value * step > box.low[axis]) {
+        low_value--;
+      }
+      while (high_value < 255 &&
+             origin[axis] + high_value * step < box.high[axis]) {
+        high_value++;
+      }
+      low[axis][size] = low_value;
+      high[axis][size] = high_value;
+    }
+    this->count[size] = count;
+    size++;
+  }
+
+  /**
+   * @brief the box of a slot, on the grid
+   */
+  AABB getBox(int slot) const {
+    AABB box;
+    for (int axis = 0; axis < 3; axis++) {
+      double step = power_of_two(exponent[axis]);
+      box.low[axis] = origin[axis] + low[axis][slot] * step;
+      box.high[axis] = origin[axis] + high[axis][slot] * step;
+    }
+    return box;
+  }
+
+  /**
+   * @brief where each slot points: a node index for a node child, the first
+   * primitive in the index array for a leaf
+   */
+  void getChildren(int child[WIDTH], int count[WIDTH]) const {
+    int next_child = this->child;
+    int next_primitive = primitive;
+    for (int i = 0; i < WIDTH; i++) {
+      count[i] = this->count[i];
+      if (count[i] == 0) {
+        child[i] = next_child++;
+      } else {
+        child[i] = next_primitive;
+        next_primitive += count[i];
+      }
+    }
+  }
+
+  /**
+   * @brief slab test of a ray against the box of every child, see
+   * WideNode::intersect
+   * the distance to a grid line is found as origin_t + value * step_t, so
+   * it can differ from the distance to getBox(slot) by a rounding, which the
+   * padding of the primitive boxes covers
+   */
+  int intersect(const Double4 origin[3],
+                const Double4 inverse_direction[3],
+                double t_max,
+                double t_enter[WIDTH]) const {
+    // the distance to the grid origin and per grid step along each axis
+    Double4 origin_t[3], step_t[3];
+    for (int axis = 0; axis < 3; axis++) {
+      origin_t[axis] = (Double4(this->origin[axis]) - origin[axis]) *
+                       inverse_direction[axis];
+      step_t[axis] =
+          Double4(power_of_two(exponent[axis])) * inverse_direction[axis];
+    }
+    int mask = 0;
+    for (int first = 0; first < WIDTH; first += SIMD_WIDTH) {
+      Double4 enter(0.0);
+      Double4 exit(t_max);
+      for (int axis = 0; axis < 3; axis++) {
+        Double4 t0 =
+            origin_t[axis] + Double4::load(&low[axis][first]) * step_t[axis];
+        Double4 t1 =
+            origin_t[axis] + Double4::load(&high[axis][first]) * step_t[axis];
+        // a NaN distance is neither swapped nor taken, as in WideNode, which
+        // only makes the test more conservative
+        Mask4 swap = t0 > t1;
+        Double4 near = select(swap, t1, t0);
+        Double4 far = select(swap, t0, t1);
+        enter = select(near > enter, near, enter);
+        exit = select(far < exit, far, exit);
+      }
+      enter.store(&t_enter[first]);
+      mask |= (enter <= exit).bits() << first;
+    }
+    return mask & ((1 << size) - 1);
+  }
+};
+
+static_assert(sizeof(CompressedNode<4>) == 64, "one cache line");
+static_assert(sizeof(CompressedNode<8>) == 128, "two cache lines");
+
+#endif  // COMPRESSED_NODE_H
@@ -0,0 +1,91 @@
+/**
+ * @file cost_map.cpp
+ * @brief This file contains the per pixel cost of a frame
+ * the renderer stores for every pixel how many intersection tests and shadow
+ * rays it took and how deep its reflections went, the map is written out as
+ * an image with one cost in each channel.
+ */
+
+#ifndef COST_MAP_H
+#define COST_MAP_H
+
+#include <vector>
+
+#include "1805086_bitmap_image.hpp"
+#include "1805086_render_statistics.cpp"
+
+using namespace std;
+
+/**
+ * @brief The CostMap class
+ * pixel (0, 0) is the top left corner of the image
+ */
+class CostMap {
+ private:
+  int width;
+  int height;
+  vector<PixelCost> costs;
+
+  /**
+   * @brief value scaled from [0, maximum] to a byte
+   */
+  static unsigned char scale(long long value, long long maximum) {
+    return maximum == 0 ? 0 : (unsigned char)(value * 255 / maximum);
+  }
+
+ public:
+  /**
+   * @brief a map of width x height pixels that cost nothing
+   */
+  CostMap(int width, int height) : width(width), height(height) {
+    PixelCost zero = {0, 0, 0};
+    costs.assign((size_t)width * height, zero);
+  }
+
+  int getWidth() { return width; }
+  int getHeight() { return height; }
+
+  /**
+   * @brief store the cost of a pixel
+   */
+  void setPixel(int x, int y, const PixelCost& cost) {
+    costs[(size_t)y * width + x] = cost;
+  }
+
+  PixelCost getPixel(int x, int y) { return costs[(size_t)y * width + x]; }
+
+  /**
+   * @brief the largest cost of the frame in each of the three measures
+   */
+  PixelCost getMaximum() {
+    PixelCost maximum = {0, 0, 0};
+    for (int i = 0; i < costs.size(); i++) {
+      maximum.intersection_tests =
+          max(maximum.intersection_tests, costs[i].intersection_tests);
+      maximum.shadow_rays = max(maximum.shadow_rays, costs[i].shadow_rays);
+      maximum.depth = max(maximum.depth, costs[i].depth);
+    }
+    return maximum;
+  }
+
+  /**
+   * @brief write the costs into an image of width x height pixels
+   * red is the number of intersection tests, green the number of shadow
+   * rays and blue the recursion depth, each relative to the largest of the
+   * frame (getMaximum)
+   */
+  void writeTo(bitmap_image& image) {
+    PixelCost maximum = getMaximum();
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        PixelCost& cost = costs[(size_t)y * width + x];
+        image.set_pixel(
+            x, y, scale(cost.intersection_tests, maximum.intersection_tests),
+            scale(cost.shadow_rays, maximum.shadow_rays),
+            scale(cost.depth, maximum.depth));
+      }
+    }
+  }
+};
+
+#endif  // COST_MAP_H
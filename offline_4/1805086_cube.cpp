@@ -6,18 +6,24 @@
 #ifndef CUBE_H
 #define CUBE_H
 
+#ifndef HEADLESS
 #include <GL/glut.h>  // GLUT, includes glu.h and gl.h
+#endif
 #include <vector>
 
+#include "1805086_bvh.cpp"
 #include "1805086_line.cpp"
 #include "1805086_shape.cpp"
 #include "1805086_triangle.cpp"
+#include "1805086_triangle_batch.cpp"
 #include "1805086_vector3d.cpp"
 
 class Cube : public Shape {
  private:
   double sideLength;  // side length of the cube
   vector<Triangle*> triangles;
+  BVH triangle_bvh;              // bottom level hierarchy for packets of rays
+  TriangleBatch triangle_batch;  // the triangles for single rays
 
  public:
   // Constructor to match the parent class
@@ -65,60 +71,93 @@ class Cube : public Shape {
             specular_coefficient, reflection_coefficient, specular_exponent));
       }
     }
+    triangle_bvh = BVH(vector<Shape*>(triangles.begin(), triangles.end()));
+    triangle_batch = TriangleBatch(triangles);
   }
 
   // Empty constructor
   Cube() : Shape(), sideLength(0) {}
 
+  // Destructor, the triangles are owned by the cube
+  ~Cube() {
+    for (int i = 0; i < triangles.size(); i++) {
+      delete triangles[i];
+    }
+  }
+
+  // the triangles are owned, so a copy would delete them twice
+  Cube(const Cube&) = delete;
+  Cube& operator=(const Cube&) = delete;
+
   // Getter and setter for the side length
   double getSideLength() { return sideLength; }
   void setSideLength(double sideLength) { this->sideLength = sideLength; }
 
-  // Method to get the normal vector at an intersection point
-  Line getNormal(Vector3D& intersection_point, Line line) {
-    // first find the triangle that contains the intersection point
-    Triangle* triangle = NULL;
-    for (int i = 0; i < triangles.size(); i++) {
-      if (triangles[i]->inside(intersection_point)) {
-        triangle = triangles[i];
-        break;
-      }
+  // Method to calculate the intersection point of the line with the cube
+  double getT(Line& line) {
+    double t;
+    if (triangle_batch.closestHitIndex(line, 0, INFINITY, t) == -1) {
+      return -1;
     }
-    // else return the normal vector of the triangle
-    return triangle->getNormal(intersection_point, line);
+    return t;
   }
 
-  // Method to calculate the intersection point of the line with the cube
-  double getT(Line& line) {
-    // find the intersection with each triangle
-    double t = -1;
-    for (int i = 0; i < triangles.size(); i++) {
-      double t1 = triangles[i]->getT(line);
-      if (t1 > 0) {
-        if (t == -1) {
-          t = t1;
-        } else {
-          t = min(t, t1);
-        }
+  // Method to find the hit of the line with the cube, the nearest triangle
+  // is found in the batch and then fills in the record
+  bool intersect(Line& line, double t_min, double t_max, HitRecord& hit) {
+    double t;
+    int primitive = triangle_batch.closestHitIndex(line, t_min, t_max, t);
+    if (primitive == -1 ||
+        !triangles[primitive]->intersect(line, t_min, t_max, hit)) {
+      return false;
+    }
+    hit.primitive = primitive;
+    return true;
+  }
+
+  // Method to check if the line hits the cube with 0 < t < t_max, stops at
+  // the first triangle that is hit
+  bool occluded(Line& line, double t_max) {
+    return triangle_batch.occluded(line, t_max);
+  }
+
+  // Method to calculate the intersection points of a packet of rays
+  void getT(RayPacket& packet, double t[SIMD_WIDTH]) {
+    int primitive[SIMD_WIDTH];
+    triangle_bvh.closestHitIndex(packet, primitive, t);
+    for (int i = 0; i < SIMD_WIDTH; i++) {
+      if (primitive[i] == -1) {
+        t[i] = -1;
       }
     }
+  }
 
-    // return the minimum t
-    return t;
+  // Method to get the kind of the shape
+  ShapeType getType() { return SHAPE_CUBE; }
+
+  // Method to get the bounding box of the cube
+  AABB getBoundingBox() {
+    AABB box;
+    for (int i = 0; i < triangles.size(); i++) {
+      box.expand(triangles[i]->getBoundingBox());
+    }
+    return box;
   }
 
   // Method to draw the cube
   void draw() {
+#ifndef HEADLESS
     // Set the color of the cube
     glColor3f(color[0], color[1], color[2]);
     // draw the triangles
     for (int i = 0; i < triangles.size(); i++) {
       triangles[i]->draw();
     }
+#endif
   }
 
   // Method to get the color at an intersection point
-  Color getColorAt(Vector3D& intersection_point) {
+  Color getColorAt(Vector3D& /*intersection_point*/) {
     // The color of the cube is the color of the cube
     return color;
   }
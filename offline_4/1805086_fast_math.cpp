@@ -0,0 +1,158 @@
+/**
+ * @file fast_math.cpp
+ * @brief This file contains the math functions of the shading of a light
+ * the attenuation exp(-distance^2 * falloff) is evaluated for four lights at
+ * once with Double4, the specular term raises to the integer shine of the
+ * material by squaring instead of calling pow. the scalar exp runs the same
+ * operations as the Double4 one, so both give the same numbers, but one value
+ * at a time it is no faster than libm exp (see math_benchmark.cpp). the
+ * Double4 one is only faster with AVX2, so the shading uses it only when
+ * built with -mavx2 and calls libm exp otherwise. the rounding
+ * of fast_exp relies on double precision arithmetic, it is wrong with the
+ * extended precision of the x87 unit (-mfpmath=387).
+ */
+
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "1805086_simd.cpp"
+
+using namespace std;
+
+// the largest relative error of fast_exp against the correctly rounded exp
+// for arguments in [FAST_EXP_MIN, FAST_EXP_MAX], checked by the math benchmark
+#define FAST_EXP_MAX_ERROR 1e-14
+// below this fast_exp gives 0, the smallest normal double is exp(-708.4)
+#define FAST_EXP_MIN -708.0
+// above this fast_exp gives INFINITY, as exp does
+#define FAST_EXP_MAX 709.782712893384
+
+namespace fast_math {
+
+// x * log2(e) + ROUNDING rounds to a whole number in the low bits
+const double ROUNDING = 6755399441055744.0;  // 1.5 * 2^52
+const double LOG2_E = 1.4426950408889634;
+// ln(2) in two parts, n * LN2_HIGH is exact for the n fast_exp uses
+const double LN2_HIGH = 6.93147180369123816490e-01;
+const double LN2_LOW = 1.90821492927058770002e-10;
+
+/**
+ * @brief the Taylor polynomial of exp of degree 11, for |r| <= ln(2) / 2 its
+ * error is below 7e-15 relative
+ */
+template <typename T>
+inline T polynomial(const T& r) {
+  T p = T(1.0 / 39916800);
+  p = p * r + T(1.0 / 3628800);
+  p = p * r + T(1.0 / 362880);
+  p = p * r + T(1.0 / 40320);
+  p = p * r + T(1.0 / 5040);
+  p = p * r + T(1.0 / 720);
+  p = p * r + T(1.0 / 120);
+  p = p * r + T(1.0 / 24);
+  p = p * r + T(1.0 / 6);
+  p = p * r + T(0.5);
+  p = p * r + T(1.0);
+  return p * r + T(1.0);
+}
+
+/**
+ * @brief 2^(n - 1) from rounded = n + 1022 + ROUNDING, for n + 1022 in
+ * [1, 2046] the low 11 bits of rounded are the biased exponent of the power
+ */
+inline double power_of_two(double rounded) {
+  uint64_t bits;
+  memcpy(&bits, &rounded, sizeof(bits));
+  bits <<= 52;
+  double power;
+  memcpy(&power, &bits, sizeof(power));
+  return power;
+}
+
+inline Double4 power_of_two(const Double4& rounded) {
+  Double4 power;
+#if defined(__AVX2__)
+  power.v = _mm256_castsi256_pd(
+      _mm256_slli_epi64(_mm256_castpd_si256(rounded.v), 52));
+#elif defined(__AVX__)
+  // without AVX2 the 256 bit register is shifted in two halves
+  __m128i low = _mm_castpd_si128(_mm256_castpd256_pd128(rounded.v));
+  __m128i high = _mm_castpd_si128(_mm256_extractf128_pd(rounded.v, 1));
+  power.v = _mm256_insertf128_pd(
+      _mm256_castpd128_pd256(_mm_castsi128_pd(_mm_slli_epi64(low, 52))),
+      _mm_castsi128_pd(_mm_slli_epi64(high, 52)), 1);
+#elif defined(__SSE2__)
+  power.lo =
+      _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(rounded.lo), 52));
+  power.hi =
+      _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(rounded.hi), 52));
+#else
+  for (int i = 0; i < 4; i++) {
+    power.v[i] = power_of_two(rounded.v[i]);
+  }
+#endif
+  return power;
+}
+
+}  // namespace fast_math
+
+/**
+ * @brief exp of every lane
+ * x = n * ln(2) + r with |r| <= ln(2) / 2, exp(r) is a polynomial and 2^n is
+ * written into the exponent bits. results below the smallest normal double
+ * are flushed to 0, a NaN lane stays NaN
+ */
+inline Double4 fast_exp(const Double4& x) {
+  using namespace fast_math;
+  Double4 clamped = min(max(x, Double4(FAST_EXP_MIN)), Double4(FAST_EXP_MAX));
+  Double4 rounded = clamped * Double4(LOG2_E) + Double4(ROUNDING);
+  Double4 n = rounded - Double4(ROUNDING);
+  Double4 r = clamped - n * Double4(LN2_HIGH) - n * Double4(LN2_LOW);
+  // 2 * p * 2^(n - 1), so that 2^n itself never has to be infinite
+  Double4 result = (polynomial(r) * Double4(2.0)) *
+                   power_of_two(rounded + Double4(1022.0));
+  result = select(x < Double4(FAST_EXP_MIN), Double4(0.0), result);
+  result = select(Double4(FAST_EXP_MAX) < x, Double4(INFINITY), result);
+  // only NaN is neither below nor above infinity
+  return select(x <= Double4(INFINITY), result, x);
+}
+
+/**
+ * @brief exp of a double, the same operations as for a lane of Double4
+ */
+inline double fast_exp(double x) {
+  using namespace fast_math;
+  if (!(x >= FAST_EXP_MIN)) {
+    return x < FAST_EXP_MIN ? 0.0 : x;
+  }
+  if (x > FAST_EXP_MAX) {
+    return INFINITY;
+  }
+  double rounded = x * LOG2_E + ROUNDING;
+  double n = rounded - ROUNDING;
+  double r = x - n * LN2_HIGH - n * LN2_LOW;
+  return (polynomial(r) * 2.0) * power_of_two(rounded + 1022.0);
+}
+
+/**
+ * @brief base^exponent for an integer exponent by repeated squaring, it takes
+ * about 2 log2(exponent) multiplications
+ */
+inline double int_pow(double base, int exponent) {
+  unsigned int n = exponent < 0 ? 0u - (unsigned int)exponent : exponent;
+  double result = 1;
+  while (n != 0) {
+    if (n & 1) {
+      result *= base;
+    }
+    base *= base;
+    n >>= 1;
+  }
+  return exponent < 0 ? 1 / result : result;
+}
+
+#endif  // FAST_MATH_H
@@ -0,0 +1,142 @@
+/**
+ * @file frame_buffer.cpp
+ * @brief This file contains the frame buffer the renderer shades into
+ * the pixels are stored row major in one 32 byte aligned block of floats,
+ * four per pixel (red, green, blue and an unused alpha), so a pixel is one
+ * SSE register and a row is one contiguous run of memory.
+ */
+
+#ifndef FRAME_BUFFER_H
+#define FRAME_BUFFER_H
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "1805086_bitmap_image.hpp"
+#include "1805086_color.cpp"
+
+using namespace std;
+
+// alignment of the pixel block in bytes
+#define FRAME_BUFFER_ALIGNMENT 32
+// floats stored per pixel
+#define FRAME_BUFFER_CHANNELS 4
+
+/**
+ * @brief The FrameBuffer class
+ * pixel (0, 0) is the top left corner of the image, pixels that are never
+ * written stay black
+ */
+class FrameBuffer {
+ private:
+  int width;
+  int height;
+  float* pixels;
+
+  /**
+   * @brief clamp a channel to [0, 1] and scale it to a byte, NaN gives 0
+   * the same operations in the same order as the SSE2 path of writeTo
+   */
+  static unsigned char quantize(float value) {
+    value = value > 0 ? value : 0;
+    value = value < 1 ? value : 1;
+    return (unsigned char)(value * 255.0f);
+  }
+
+  // the pixels are owned, so the buffer is not copied
+  FrameBuffer(const FrameBuffer&);
+  FrameBuffer& operator=(const FrameBuffer&);
+
+ public:
+  /**
+   * @brief a black frame of width x height pixels
+   */
+  FrameBuffer(int width, int height) : width(width), height(height) {
+    size_t size =
+        (size_t)width * height * FRAME_BUFFER_CHANNELS * sizeof(float);
+    // aligned_alloc wants a multiple of the alignment
+    size = (size + FRAME_BUFFER_ALIGNMENT - 1) / FRAME_BUFFER_ALIGNMENT *
+           FRAME_BUFFER_ALIGNMENT;
+    pixels = (float*)aligned_alloc(FRAME_BUFFER_ALIGNMENT, size);
+    if (pixels == NULL) {
+      throw bad_alloc();
+    }
+    memset(pixels, 0, size);
+  }
+
+  ~FrameBuffer() { free(pixels); }
+
+  int getWidth() { return width; }
+  int getHeight() { return height; }
+
+  /**
+   * @brief store the color of a pixel, it is clamped when written out
+   */
+  void setPixel(int x, int y, const Color& color) {
+    float* pixel = pixels + ((size_t)y * width + x) * FRAME_BUFFER_CHANNELS;
+    pixel[0] = color[0];
+    pixel[1] = color[1];
+    pixel[2] = color[2];
+    pixel[3] = 1;
+  }
+
+  /**
+   * @brief the color of a pixel as it was stored
+   */
+  Color getPixel(int x, int y) {
+    float* pixel = pixels + ((size_t)y * width + x) * FRAME_BUFFER_CHANNELS;
+    return Color(pixel[0], pixel[1], pixel[2]);
+  }
+
+  /**
+   * @brief clamp, quantize and write every pixel straight into the rows of
+   * the image, which has to be width x height pixels of 3 bytes (blue,
+   * green, red)
+   */
+  void writeTo(bitmap_image& image) {
+    for (int y = 0; y < height; y++) {
+      const float* source = pixels + (size_t)y * width * FRAME_BUFFER_CHANNELS;
+      unsigned char* destination = image.row(y);
+      int x = 0;
+#if defined(__SSE2__)
+      const __m128 zero = _mm_setzero_ps();
+      const __m128 one = _mm_set1_ps(1.0f);
+      const __m128 scale = _mm_set1_ps(255.0f);
+      // four pixels at a time: sixteen channels are packed into sixteen
+      // bytes (blue, green, red, alpha) of which the first three of every
+      // pixel are copied
+      for (; x + 4 <= width; x += 4) {
+        __m128i channels[4];
+        for (int i = 0; i < 4; i++) {
+          __m128 color = _mm_load_ps(source + (x + i) * FRAME_BUFFER_CHANNELS);
+          color = _mm_min_ps(_mm_max_ps(color, zero), one);
+          // red, green, blue, alpha -> blue, green, red, alpha
+          color = _mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 0, 1, 2));
+          channels[i] = _mm_cvttps_epi32(_mm_mul_ps(color, scale));
+        }
+        __m128i bytes =
+            _mm_packus_epi16(_mm_packs_epi32(channels[0], channels[1]),
+                             _mm_packs_epi32(channels[2], channels[3]));
+        unsigned char quantized[16];
+        _mm_storeu_si128((__m128i*)quantized, bytes);
+        for (int i = 0; i < 4; i++) {
+          memcpy(destination + (x + i) * 3, quantized + i * 4, 3);
+        }
+      }
+#endif
+      for (; x < width; x++) {
+        const float* pixel = source + x * FRAME_BUFFER_CHANNELS;
+        destination[x * 3 + 0] = quantize(pixel[2]);
+        destination[x * 3 + 1] = quantize(pixel[1]);
+        destination[x * 3 + 2] = quantize(pixel[0]);
+      }
+    }
+  }
+};
+
+#endif  // FRAME_BUFFER_H
@@ -0,0 +1,365 @@
+/**
+ * @file headless.cpp
+ * @brief This file contains the headless command line renderer
+ * loads a scene, renders it with the ray tracer and saves the image without
+ * opening a window, so it runs on machines without a display and does not
+ * link GL.
+ *
+ * g++ -O2 -DHEADLESS 1805086_headless.cpp -o headless -pthread
+ * ./headless [options] <scene file>
+ *
+ * exit status: 0 on success, 1 for bad arguments, 2 if the scene cannot be
+ * read, 3 if the output cannot be written
+ */
+
+#ifndef HEADLESS
+#define HEADLESS
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "1805086_renderer.cpp"
+
+using namespace std;
+
+enum ExitStatus {
+  EXIT_OK = 0,
+  EXIT_BAD_ARGUMENTS = 1,
+  EXIT_BAD_SCENE = 2,
+  EXIT_BAD_OUTPUT = 3,
+};
+
+/**
+ * @brief the options of a headless render, the scene file decides whatever is
+ * not given on the command line
+ */
+struct HeadlessOptions {
+  string scene;
+  string output;
+  string statistics;
+  string cost_image;
+  int number_of_pixels;
+  int level_of_recursion;
+  bool quiet;
+};
+
+void print_usage(ostream& out, const char* program) {
+  out << "usage: " << program << " [options] <scene file>" << endl
+      << "  -o, --output <file>          image to write (default output.bmp)"
+      << endl
+      << "  --camera <x> <y> <z>         camera position (default 100 100 100)"
+      << endl
+      << "  --look <x> <y> <z>           point looked at (default 0 0 0)"
+      << endl
+      << "  --up <x> <y> <z>             up vector (default 0 0 1)" << endl
+      << "  -r, --resolution <pixels>    image height, overrides the scene"
+      << endl
+      << "  -l, --recursion <level>      level of recursion, overrides the "
+         "scene"
+      << endl
+      << "  -t, --threads <count>        number of render threads" << endl
+      << "  --progress <quiet|console|json>" << endl
+      << "  --light-threshold <value>    skip lights that add less than this"
+      << endl
+      << "  --light-samples <count>      sample this many lights per hit"
+      << endl
+      << "  --bvh-width <2|4|8>          children of a node of the BVH "
+         "(default 4)"
+      << endl
+      << "  --bvh-build <median|sah>     how the BVH is split (default sah)"
+      << endl
+      << "  --bvh-nodes <full|compressed>" << endl
+      << "                               layout of the 4 and 8 wide nodes "
+         "(default full)"
+      << endl
+      << "  --cache <file>               keep the scene and its BVH in this "
+         "file, rebuilt when the scene changes"
+      << endl
+      << "  --statistics <file>          write the frame statistics as JSON"
+      << endl
+      << "  --cost-image <file>          write the per pixel cost image"
+      << endl
+      << "  -q, --quiet                  do not report the loaded scene"
+      << endl
+      << "  -h, --help                   print this message" << endl;
+}
+
+/**
+ * @brief reads a positive integer argument
+ * @return false if the argument is not one
+ */
+bool parse_count(const char* argument, int& value) {
+  char* end;
+  long parsed = strtol(argument, &end, 10);
+  if (*argument == '\0' || *end != '\0' || parsed < 1 || parsed > 1 << 20) {
+    return false;
+  }
+  value = (int)parsed;
+  return true;
+}
+
+/**
+ * @brief reads three coordinates from consecutive arguments
+ * @return false if one of them is not a number
+ */
+bool parse_vector(char** arguments, Vector3D& value) {
+  for (int i = 0; i < 3; i++) {
+    char* end;
+    value[i] = strtod(arguments[i], &end);
+    if (*arguments[i] == '\0' || *end != '\0') {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief parses the command line into the options and the renderer globals
+ * @return false if the command line is wrong, the reason is printed
+ */
+bool parse_arguments(int argc, char** argv, HeadlessOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    string argument = argv[i];
+    // the number of values that follow the current option
+    int values = 0;
+    if (argument == "--camera" || argument == "--look" || argument == "--up") {
+      values = 3;
+    } else if (argument == "-o" || argument == "--output" ||
+               argument == "-r" || argument == "--resolution" ||
+               argument == "-l" || argument == "--recursion" ||
+               argument == "-t" || argument == "--threads" ||
+               argument == "--progress" || argument == "--statistics" ||
+               argument == "--light-threshold" ||
+               argument == "--light-samples" ||
+               argument == "--bvh-width" || argument == "--bvh-build" ||
+               argument == "--bvh-nodes" ||
+               argument == "--cache" ||
+               argument == "--cost-image") {
+      values = 1;
+    }
+    if (i + values >= argc) {
+      cerr << argument << " needs " << values << " value(s)" << endl;
+      return false;
+    }
+
+    bool valid = true;
+    if (argument == "-o" || argument == "--output") {
+      options.output = argv[i + 1];
+    } else if (argument == "--camera") {
+      valid = parse_vector(argv + i + 1, camera);
+    } else if (argument == "--look") {
+      valid = parse_vector(argv + i + 1, look);
+    } else if (argument == "--up") {
+      valid = parse_vector(argv + i + 1, up);
+    } else if (argument == "-r" || argument == "--resolution") {
+      valid = parse_count(argv[i + 1], options.number_of_pixels);
+    } else if (argument == "-l" || argument == "--recursion") {
+      valid = parse_count(argv[i + 1], options.level_of_recursion);
+    } else if (argument == "-t" || argument == "--threads") {
+      valid = parse_count(argv[i + 1], number_of_threads);
+    } else if (argument == "--progress") {
+      string mode = argv[i + 1];
+      if (mode == "quiet") {
+        progress_mode = PROGRESS_QUIET;
+      } else if (mode == "console") {
+        progress_mode = PROGRESS_CONSOLE;
+      } else if (mode == "json") {
+        progress_mode = PROGRESS_JSON;
+      } else {
+        valid = false;
+      }
+    } else if (argument == "--light-threshold") {
+      char* end;
+      light_threshold = strtod(argv[i + 1], &end);
+      valid = *argv[i + 1] != '\0' && *end == '\0' && light_threshold >= 0;
+    } else if (argument == "--light-samples") {
+      valid = parse_count(argv[i + 1], light_samples);
+    } else if (argument == "--bvh-width") {
+      valid = parse_count(argv[i + 1], bvh_width) &&
+              (bvh_width == 2 || bvh_width == 4 || bvh_width == 8);
+    } else if (argument == "--bvh-build") {
+      string mode = argv[i + 1];
+      if (mode == "median") {
+        bvh_build = BVH_BUILD_MEDIAN;
+      } else if (mode == "sah") {
+        bvh_build = BVH_BUILD_SAH;
+      } else {
+        valid = false;
+      }
+    } else if (argument == "--bvh-nodes") {
+      string mode = argv[i + 1];
+      if (mode == "full") {
+        bvh_compressed = false;
+      } else if (mode == "compressed") {
+        bvh_compressed = true;
+      } else {
+        valid = false;
+      }
+    } else if (argument == "--cache") {
+      scene_cache_file = argv[i + 1];
+    } else if (argument == "--statistics") {
+      options.statistics = argv[i + 1];
+    } else if (argument == "--cost-image") {
+      options.cost_image = argv[i + 1];
+      record_pixel_costs = true;
+    } else if (argument == "-q" || argument == "--quiet") {
+      options.quiet = true;
+    } else if (argument == "-h" || argument == "--help") {
+      print_usage(cout, argv[0]);
+      exit(EXIT_OK);
+    } else if (argument.size() > 1 && argument[0] == '-') {
+      cerr << "unknown option " << argument << endl;
+      return false;
+    } else if (options.scene.empty()) {
+      options.scene = argument;
+    } else {
+      cerr << "more than one scene file given" << endl;
+      return false;
+    }
+    if (!valid) {
+      cerr << "invalid value for " << argument << endl;
+      return false;
+    }
+    i += values;
+  }
+  if (options.scene.empty()) {
+    cerr << "no scene file given" << endl;
+    return false;
+  }
+  return true;
+}
+
+// the output files is_writable created, removed again unless they are written
+vector<string> created_outputs;
+
+/**
+ * @brief checks that a file can be created before the frame is rendered
+ */
+bool is_writable(const string& filename) {
+  if (filename.empty()) {
+    return true;
+  }
+  FILE* existing = fopen(filename.c_str(), "rb");
+  if (existing != NULL) {
+    fclose(existing);
+  }
+  ofstream file(filename.c_str(), ios::binary | ios::app);
+  if (file && existing == NULL) {
+    created_outputs.push_back(filename);
+  }
+  return (bool)file;
+}
+
+/**
+ * @brief removes the files is_writable created that were not written
+ * @param written the output files that were written
+ */
+void remove_unused_outputs(const vector<string>& written) {
+  for (const string& filename : created_outputs) {
+    if (find(written.begin(), written.end(), filename) == written.end()) {
+      remove(filename.c_str());
+    }
+  }
+  created_outputs.clear();
+}
+
+/**
+ * @brief notes an output file that was saved, or reports it if it was not
+ * @return whether it was saved
+ */
+bool check_saved(bool saved,
+                 const string& filename,
+                 vector<string>& written) {
+  if (saved) {
+    written.push_back(filename);
+  } else {
+    cerr << "cannot write " << filename << endl;
+  }
+  return saved;
+}
+
+int main(int argc, char** argv) {
+  // the same camera as the viewer starts with
+  camera = Vector3D(100, 100, 100);
+  look = Vector3D(0, 0, 0);
+  up = Vector3D(0, 0, 1);
+
+  HeadlessOptions options = {"", "output.bmp", "", "", 0, 0, false};
+  if (!parse_arguments(argc, argv, options)) {
+    print_usage(cerr, argv[0]);
+    return EXIT_BAD_ARGUMENTS;
+  }
+  if (!is_writable(options.output) || !is_writable(options.statistics) ||
+      !is_writable(options.cost_image)) {
+    cerr << "cannot write the output files" << endl;
+    remove_unused_outputs(vector<string>());
+    return EXIT_BAD_OUTPUT;
+  }
+
+  // the scene report goes to cout, which is kept quiet if asked
+  streambuf* console = cout.rdbuf();
+  if (options.quiet) {
+    cout.rdbuf(NULL);
+  }
+  bool loaded = load_parameters(options.scene);
+  cout.rdbuf(console);
+  cout.clear();
+  if (!loaded) {
+    remove_unused_outputs(vector<string>());
+    return EXIT_BAD_SCENE;
+  }
+  if (options.number_of_pixels > 0) {
+    number_of_pixels_y = options.number_of_pixels;
+  }
+  if (options.level_of_recursion > 0) {
+    level_of_recursion = options.level_of_recursion;
+  }
+  if (number_of_pixels_y < 1 || get_image_width() < 1) {
+    cerr << options.scene << " gives an empty image" << endl;
+    clear_scene();
+    remove_unused_outputs(vector<string>());
+    return EXIT_BAD_SCENE;
+  }
+
+  if (options.quiet) {
+    cout.rdbuf(NULL);
+  }
+  build_acceleration_structure();
+  cout.rdbuf(console);
+  cout.clear();
+  FrameBuffer* frame_buffer = generate_image();
+
+  // a file can still fail to be written, the disk may have filled up since
+  vector<string> written;
+  bool saved = check_saved(capture_image(options.output, frame_buffer),
+                           options.output, written);
+  delete frame_buffer;
+  if (!options.statistics.empty()) {
+    saved = check_saved(save_statistics(options.statistics),
+                        options.statistics, written) &&
+            saved;
+  }
+  if (!options.cost_image.empty()) {
+    saved = check_saved(save_cost_image(options.cost_image),
+                        options.cost_image, written) &&
+            saved;
+  }
+  remove_unused_outputs(written);
+  if (!saved) {
+    clear_scene();
+    return EXIT_BAD_OUTPUT;
+  }
+  cout << get_image_width() << "x" << number_of_pixels_y << " recursion "
+       << level_of_recursion << " threads " << number_of_threads << " : "
+       << frame_statistics.frame_ms << " ms, written to " << options.output
+       << endl;
+  clear_scene();
+  return EXIT_OK;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file hit_record.cpp
+ * @brief This file contains the hit record class
+ * a hit record is filled by Shape::intersect(line, t_min, t_max, hit) and
+ * carries everything the shading needs to know about a hit, so nothing has
+ * to be recomputed after the nearest hit is found.
+ */
+
+#ifndef HIT_RECORD_H
+#define HIT_RECORD_H
+
+#include "1805086_vector3d.cpp"
+
+using namespace std;
+
+class Shape;
+
+/**
+ * @brief The HitRecord class
+ */
+class HitRecord {
+ public:
+  double t;         // distance along the line
+  Vector3D point;   // the point that is hit
+  Vector3D normal;  // unit geometric normal at the point
+  bool two_sided;   // the normal is flipped to face the incoming line
+  int primitive;    // the primitive of a composite shape, or -1
+  double u, v;      // surface coordinates at the point
+  Shape* shape;     // the shape that is hit
+
+  HitRecord()
+      : t(-1), two_sided(false), primitive(-1), u(0), v(0), shape(NULL) {}
+
+  /**
+   * @brief the normal as seen by a line arriving with the given direction
+   * two sided surfaces (triangles, the checker board) turn their normal
+   * against the line, closed surfaces (spheres) keep the outward normal
+   */
+  Vector3D getNormal(const Vector3D& direction) const {
+    if (two_sided && normal.dot_product(direction) > 0) {
+      return normal * (-1);
+    }
+    return normal;
+  }
+};
+
+#endif  // HIT_RECORD_H
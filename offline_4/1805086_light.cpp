@@ -5,7 +5,12 @@
 #ifndef LIGHT_H
 #define LIGHT_H
 
+#ifndef HEADLESS
 #include <GL/glut.h>  // GLUT, includes glu.h and gl.h
+#endif
+
+#include <algorithm>
+#include <cmath>
 
 #include "1805086_color.cpp"
 #include "1805086_vector3d.cpp"
@@ -70,15 +75,35 @@ class Light {
    */
   void setFalloff(double falloff) { this->falloff = falloff; }
 
+  /**
+   * @brief the distance beyond which the light adds less than threshold to
+   * any channel, the attenuation is exp(-distance^2 * falloff)
+   *
+   * @param threshold the smallest contribution that counts
+   * @return double, INFINITY if the light reaches everywhere
+   */
+  double getInfluenceRadius(double threshold) {
+    double brightest = max(color[0], max(color[1], color[2]));
+    if (threshold <= 0 || falloff <= 0) {
+      return INFINITY;
+    }
+    if (brightest <= threshold) {
+      return 0;
+    }
+    return sqrt(log(brightest / threshold) / falloff);
+  }
+
   /**
    * @brief draw the light
    */
   void draw() {
+#ifndef HEADLESS
     glPushMatrix();
     glTranslatef(position[0], position[1], position[2]);
     glColor3f(color[0], color[1], color[2]);
     glutSolidSphere(2, 20, 20);
     glPopMatrix();
+#endif
   }
 };
 
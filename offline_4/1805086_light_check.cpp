@@ -0,0 +1,192 @@
+/**
+ * @file light_check.cpp
+ * @brief This file contains the check that culling and sampling the lights
+ * give the image of shading every light
+ * a generated scene is rendered with every light, with the lights below a
+ * contribution threshold culled and many times with the lights sampled.
+ * a culled light adds less than threshold to any channel at a hit, so a
+ * pixel of the culled frame may only be darker by at most
+ * threshold * lights * (diffuse + specular) summed over the reflection
+ * levels. the sampled frames are rendered with different seeds and their
+ * mean has to agree with the frame of every light within the standard error
+ * of the mean, per pixel and over the frame. it prints one JSON object per
+ * case and exits with 1 if any is outside its bound.
+ *
+ * g++ -O2 -DHEADLESS 1805086_light_check.cpp -o light_check -pthread
+ * ./light_check
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "1805086_renderer.cpp"
+#include "1805086_scene_generator.cpp"
+
+using namespace std;
+
+/**
+ * @brief render the loaded scene with the lights picked as given
+ * @return FrameBuffer* the frame, owned by the caller
+ */
+FrameBuffer* render(double threshold, int samples) {
+  light_threshold = threshold;
+  light_samples = samples;
+  streambuf* console = cout.rdbuf(NULL);
+  build_acceleration_structure();
+  FrameBuffer* frame_buffer = generate_image();
+  cout.rdbuf(console);
+  cout.clear();
+  return frame_buffer;
+}
+
+int main() {
+  SceneGenerator generator(1805086, 40, 20, 20, 24, 8);
+  ostringstream text;
+  generator.write(text, 90, 3);
+  string scene_text = text.str();
+  SceneParser parser;
+  SceneDescription scene;
+  if (!parser.parse(scene_text.data(), scene_text.data() + scene_text.size(),
+                    scene)) {
+    cerr << parser.getError() << endl;
+    return 1;
+  }
+
+  progress_mode = PROGRESS_QUIET;
+  streambuf* console = cout.rdbuf(NULL);
+  load_scene(scene);
+  cout.rdbuf(console);
+  cout.clear();
+  camera = Vector3D(100, 100, 100);
+  look = Vector3D(0, 0, 0);
+  up = Vector3D(0, 0, 1);
+
+  // the generated lights reach the whole scene, with a steeper falloff each
+  // one only reaches part of it and culling has something to skip
+  for (int i = 0; i < normal_light_sources.size(); i++) {
+    normal_light_sources[i]->setFalloff(1e-3);
+  }
+  for (int i = 0; i < spot_light_sources.size(); i++) {
+    spot_light_sources[i]->setFalloff(1e-3);
+  }
+
+  // the most a hit can get from one light and how much of it a reflection
+  // carries, the colors of the shapes are at most 1
+  double most_light = 0;
+  double most_reflected = 0;
+  for (int i = 0; i < shapes.size(); i++) {
+    most_light = max(most_light, shapes[i]->getDiffuseCoefficient() +
+                                     shapes[i]->getSpecularCoefficient());
+    most_reflected =
+        max(most_reflected, shapes[i]->getReflectionCoefficient());
+  }
+  double levels = 0;
+  double carried = 1;
+  for (int level = 0; level < level_of_recursion; level++) {
+    levels += carried;
+    carried *= most_reflected;
+  }
+  int number_of_lights =
+      normal_light_sources.size() + spot_light_sources.size();
+
+  FrameBuffer* every_light = render(0, 0);
+  bool passed = true;
+  for (double threshold : {1e-6, 1e-4, 1e-2}) {
+    FrameBuffer* culled = render(threshold, 0);
+    double bound = threshold * number_of_lights * most_light * levels;
+    // the frame is stored as float
+    double rounding = 1e-5;
+    double darkest = 0;
+    double brightest = 0;
+    for (int y = 0; y < culled->getHeight(); y++) {
+      for (int x = 0; x < culled->getWidth(); x++) {
+        Color expected = every_light->getPixel(x, y);
+        Color actual = culled->getPixel(x, y);
+        for (int c = 0; c < 3; c++) {
+          double difference = expected[c] - actual[c];
+          darkest = max(darkest, difference);
+          brightest = max(brightest, -difference);
+        }
+      }
+    }
+    bool within = darkest <= bound + rounding && brightest <= rounding;
+    passed = passed && within;
+    cout << "{\"threshold\": " << threshold
+         << ", \"culled_lights\": " << frame_statistics.culled_lights
+         << ", \"bound\": " << bound << ", \"darker\": " << darkest
+         << ", \"brighter\": " << brightest
+         << ", \"within\": " << (within ? "true" : "false") << "}" << endl;
+    delete culled;
+  }
+
+  const int renders = 64;
+  const int samples = 4;
+  int width = every_light->getWidth();
+  int height = every_light->getHeight();
+  vector<double> sum(width * height * 3, 0);
+  vector<double> sum_of_squares(width * height * 3, 0);
+  for (int render_index = 0; render_index < renders; render_index++) {
+    light_sample_seed = render_index + 1;
+    FrameBuffer* sampled = render(0, samples);
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        Color color = sampled->getPixel(x, y);
+        for (int c = 0; c < 3; c++) {
+          int i = (y * width + x) * 3 + c;
+          sum[i] += color[c];
+          sum_of_squares[i] += color[c] * color[c];
+        }
+      }
+    }
+    delete sampled;
+  }
+  light_sample_seed = 0;
+
+  // every channel within 6 standard errors of its mean or one step of the
+  // written image. a light that is picked with a tiny probability seldom
+  // shows up in the renders, so the sample variance misses it, but it is
+  // picked rarely because it adds little. the pixels are sampled
+  // independently, so the errors of the frame total add up as variances
+  double rounding = 1e-5;
+  double worst_difference = 0;
+  double mean_total = 0;
+  double expected_total = 0;
+  double total_variance = 0;
+  bool pixels_within = true;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      Color expected = every_light->getPixel(x, y);
+      for (int c = 0; c < 3; c++) {
+        int i = (y * width + x) * 3 + c;
+        double mean = sum[i] / renders;
+        double variance =
+            max(0.0, (sum_of_squares[i] - sum[i] * mean) / (renders - 1));
+        double error = sqrt(variance / renders);
+        double difference = fabs(mean - expected[c]);
+        if (difference > 6 * error + 1.0 / 255) {
+          pixels_within = false;
+        }
+        worst_difference = max(worst_difference, difference);
+        mean_total += mean;
+        expected_total += expected[c];
+        total_variance += variance / renders;
+      }
+    }
+  }
+  double total_error = sqrt(total_variance);
+  bool total_within =
+      fabs(mean_total - expected_total) <= 4 * total_error + rounding;
+  passed = passed && pixels_within && total_within;
+  cout << "{\"renders\": " << renders << ", \"samples\": " << samples
+       << ", \"worst_difference\": " << worst_difference
+       << ", \"mean_total\": " << mean_total
+       << ", \"expected_total\": " << expected_total
+       << ", \"total_error\": " << total_error << ", \"within\": "
+       << (pixels_within && total_within ? "true" : "false") << "}" << endl;
+  delete every_light;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+/**
+ * @file light_sampler.cpp
+ * @brief This file contains the stochastic selection of light sources
+ * for scenes with too many lights to shade every one at every hit, a fixed
+ * number of lights is picked per hit with a probability that follows their
+ * estimated contribution. the lights are the leaves of a tree whose nodes
+ * know the total brightness and the weakest falloff below them, a light is
+ * found by walking down and choosing a child by its importance at the hit.
+ * the probability of the path is returned with the light so the shading can
+ * weight it and stay unbiased.
+ */
+
+#ifndef LIGHT_SAMPLER_H
+#define LIGHT_SAMPLER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "1805086_aabb.cpp"
+#include "1805086_light.cpp"
+#include "1805086_spot_light.cpp"
+#include "1805086_vector3d.cpp"
+
+using namespace std;
+
+/**
+ * @brief a light picked for a hit
+ */
+struct LightSample {
+  int index;           // in the normal or spot light list
+  bool spot;           // whether it is a spot light
+  double probability;  // of picking it
+};
+
+// state of the random numbers of the calling thread, the renderer seeds it
+// for every pixel so the samples do not depend on the number of threads
+thread_local uint64_t light_sample_state = 0;
+
+/**
+ * @brief start the random numbers of the calling thread from a seed
+ */
+void seed_light_samples(uint64_t seed) { light_sample_state = seed; }
+
+/**
+ * @brief a random number in [0, 1) (splitmix64)
+ */
+inline double next_light_sample() {
+  uint64_t z = (light_sample_state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z = z ^ (z >> 31);
+  return (z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief The LightSampler class
+ * binary tree with one light per leaf, stored depth first in a flat array.
+ * like the BVH it is built once and then only read
+ */
+class LightSampler {
+ private:
+  struct Node {
+    AABB box;        // of the positions of the lights below
+    double power;    // sum of the brightest channel of the lights below
+    double falloff;  // the weakest falloff of the lights below
+    int offset;      // the light of a leaf, the right child of an interior
+    bool leaf;
+  };
+
+  /**
+   * @brief a light with what the tree needs to know about it
+   */
+  struct Entry {
+    Vector3D position;
+    double power;
+    double falloff;
+    int index;
+    bool spot;
+  };
+
+  int samples_per_hit;
+  vector<Entry> entries;
+  vector<Node> nodes;
+
+  /**
+   * @brief build the subtree over entries [first, last) and return its root
+   * the lights are split at the median position along the longest axis
+   */
+  int build(int first, int last) {
+    int node_index = nodes.size();
+    nodes.push_back(Node());
+
+    Node node;
+    node.power = 0;
+    node.falloff = INFINITY;
+    for (int i = first; i < last; i++) {
+      node.box.expand(entries[i].position);
+      node.power += entries[i].power;
+      node.falloff = min(node.falloff, entries[i].falloff);
+    }
+
+    int count = last - first;
+    int axis = node.box.longestAxis();
+    if (count == 1) {
+      node.offset = first;
+      node.leaf = true;
+      nodes[node_index] = node;
+      return node_index;
+    }
+
+    int middle = first + count / 2;
+    nth_element(entries.begin() + first, entries.begin() + middle,
+                entries.begin() + last, [&](const Entry& a, const Entry& b) {
+                  return a.position[axis] < b.position[axis];
+                });
+    // lights at the same position still split in halves, so the depth stays
+    // logarithmic
+    build(first, middle);
+    node.offset = build(middle, last);
+    node.leaf = false;
+    nodes[node_index] = node;
+    return node_index;
+  }
+
+  /**
+   * @brief an upper bound of what the lights of a node add at a point,
+   * relative to each other
+   */
+  double importance(const Node& node, const Vector3D& point) const {
+    double distance_squared = 0;
+    for (int i = 0; i < 3; i++) {
+      double outside = max(0.0, max(node.box.low[i] - point[i],
+                                    point[i] - node.box.high[i]));
+      distance_squared += outside * outside;
+    }
+    return node.power * exp(-distance_squared * node.falloff);
+  }
+
+  void add(Light* light, int index, bool spot) {
+    Color color = light->getColor();
+    Entry entry = {light->getPosition(),
+                   max(color[0], max(color[1], color[2])),
+                   max(0.0, light->getFalloff()), index, spot};
+    entries.push_back(entry);
+  }
+
+ public:
+  /**
+   * @brief no sampling, every light is shaded
+   */
+  LightSampler() : samples_per_hit(0) {}
+
+  /**
+   * @brief build the tree over the light sources
+   * @param samples_per_hit the number of lights picked per hit, 0 turns the
+   * sampling off
+   */
+  LightSampler(vector<Light*>& lights,
+               vector<SpotLight*>& spot_lights,
+               int samples_per_hit)
+      : samples_per_hit(samples_per_hit) {
+    if (samples_per_hit <= 0) {
+      return;
+    }
+    for (int i = 0; i < lights.size(); i++) {
+      add(lights[i], i, false);
+    }
+    for (int i = 0; i < spot_lights.size(); i++) {
+      add(spot_lights[i], i, true);
+    }
+    if (!entries.empty()) {
+      build(0, entries.size());
+    }
+  }
+
+  /**
+   * @brief whether the lights are sampled, if not the shading goes over
+   * every light
+   */
+  bool isSampling() const { return samples_per_hit > 0; }
+
+  int getSamplesPerHit() const { return samples_per_hit; }
+
+  /**
+   * @brief pick a light for a point
+   * a child is chosen with a probability proportional to its importance,
+   * halves if neither can add anything (then neither light matters)
+   * @param point the point that is shaded
+   * @param sample set to the light and the probability it was picked with
+   * @return false if there are no lights
+   */
+  bool sample(const Vector3D& point, LightSample& sample) const {
+    if (nodes.empty()) {
+      return false;
+    }
+    double probability = 1;
+    int node_index = 0;
+    while (!nodes[node_index].leaf) {
+      int left = node_index + 1;
+      int right = nodes[node_index].offset;
+      double left_importance = importance(nodes[left], point);
+      double right_importance = importance(nodes[right], point);
+      double total = left_importance + right_importance;
+      double left_probability = total > 0 ? left_importance / total : 0.5;
+      if (next_light_sample() < left_probability) {
+        probability *= left_probability;
+        node_index = left;
+      } else {
+        probability *= 1 - left_probability;
+        node_index = right;
+      }
+    }
+    const Entry& entry = entries[nodes[node_index].offset];
+    sample.index = entry.index;
+    sample.spot = entry.spot;
+    sample.probability = probability;
+    return true;
+  }
+};
+
+#endif  // LIGHT_SAMPLER_H
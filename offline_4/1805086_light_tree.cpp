@@ -0,0 +1,196 @@
+/**
+ * @file light_tree.cpp
+ * @brief This file contains the hierarchy over the influence spheres of the
+ * light sources
+ * every light only reaches as far as its attenuation stays above a
+ * contribution threshold (Light::getInfluenceRadius), the tree returns the
+ * lights whose sphere contains a point so the shading can skip the others
+ * and their shadow rays. like the BVH it is built once and then only read.
+ */
+
+#ifndef LIGHT_TREE_H
+#define LIGHT_TREE_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "1805086_aabb.cpp"
+#include "1805086_light.cpp"
+#include "1805086_spot_light.cpp"
+#include "1805086_vector3d.cpp"
+
+using namespace std;
+
+/**
+ * @brief The LightTree class
+ * binary tree of the bounding boxes of the influence spheres, stored depth
+ * first in a flat array like the BVH. lights that reach everywhere are kept
+ * out of the tree and returned for every point
+ */
+class LightTree {
+ private:
+  struct Node {
+    AABB box;
+    int offset;  // first light of a leaf, right child of an interior node
+    int count;   // lights of a leaf, 0 for an interior node
+  };
+
+  /**
+   * @brief a light with a finite influence sphere
+   */
+  struct Entry {
+    Vector3D position;
+    double radius_squared;
+    int index;  // in the normal or spot light list
+    bool spot;
+  };
+
+  static const int MAX_DEPTH = 64;
+  static const int MAX_LEAF_SIZE = 4;
+
+  double threshold;
+  vector<Entry> entries;  // ordered by leaf
+  vector<Node> nodes;
+  vector<int> unbounded_lights;
+  vector<int> unbounded_spot_lights;
+
+  AABB getBox(const Entry& entry) {
+    double radius = sqrt(entry.radius_squared);
+    AABB box(entry.position, entry.position);
+    box.pad(radius);
+    return box;
+  }
+
+  /**
+   * @brief build the subtree over entries [first, last) and return its root
+   * the lights are split at the median position along the longest axis
+   */
+  int build(int first, int last, int depth) {
+    int node_index = nodes.size();
+    nodes.push_back(Node());
+
+    AABB box;
+    AABB centroid_box;
+    for (int i = first; i < last; i++) {
+      box.expand(getBox(entries[i]));
+      centroid_box.expand(entries[i].position);
+    }
+    nodes[node_index].box = box;
+
+    int count = last - first;
+    int axis = centroid_box.longestAxis();
+    if (count <= MAX_LEAF_SIZE || depth >= MAX_DEPTH - 1 ||
+        centroid_box.high[axis] <= centroid_box.low[axis]) {
+      nodes[node_index].offset = first;
+      nodes[node_index].count = count;
+      return node_index;
+    }
+
+    int middle = first + count / 2;
+    nth_element(entries.begin() + first, entries.begin() + middle,
+                entries.begin() + last, [&](const Entry& a, const Entry& b) {
+                  return a.position[axis] < b.position[axis];
+                });
+
+    build(first, middle, depth + 1);
+    int right = build(middle, last, depth + 1);
+    nodes[node_index].offset = right;
+    nodes[node_index].count = 0;
+    return node_index;
+  }
+
+  void add(Light* light, int index, bool spot) {
+    double radius = light->getInfluenceRadius(threshold);
+    if (isinf(radius)) {
+      (spot ? unbounded_spot_lights : unbounded_lights).push_back(index);
+      return;
+    }
+    Entry entry = {light->getPosition(), radius * radius, index, spot};
+    entries.push_back(entry);
+  }
+
+ public:
+  /**
+   * @brief no culling, every light is returned for every point
+   */
+  LightTree() : threshold(0) {}
+
+  /**
+   * @brief build the tree over the light sources
+   * @param threshold the smallest contribution of a light that counts, 0
+   * turns the culling off
+   */
+  LightTree(vector<Light*>& lights,
+            vector<SpotLight*>& spot_lights,
+            double threshold)
+      : threshold(threshold) {
+    if (threshold <= 0) {
+      return;
+    }
+    for (int i = 0; i < lights.size(); i++) {
+      add(lights[i], i, false);
+    }
+    for (int i = 0; i < spot_lights.size(); i++) {
+      add(spot_lights[i], i, true);
+    }
+    if (!entries.empty()) {
+      build(0, entries.size(), 0);
+    }
+  }
+
+  /**
+   * @brief whether lights are culled at all, if not the shading loops over
+   * every light without asking the tree
+   */
+  bool isCulling() const { return threshold > 0; }
+
+  /**
+   * @brief the number of lights whose influence is bounded
+   */
+  int getBoundedCount() const { return entries.size(); }
+
+  /**
+   * @brief find the lights that reach a point
+   * @param point the point that is shaded
+   * @param lights set to the indices of the normal lights, in ascending
+   * order so the shading adds them up in the same order as without culling
+   * @param spot_lights set to the indices of the spot lights, ascending
+   */
+  void query(const Vector3D& point,
+             vector<int>& lights,
+             vector<int>& spot_lights) const {
+    lights.assign(unbounded_lights.begin(), unbounded_lights.end());
+    spot_lights.assign(unbounded_spot_lights.begin(),
+                       unbounded_spot_lights.end());
+    if (!nodes.empty()) {
+      int stack[MAX_DEPTH];
+      int stack_size = 0;
+      stack[stack_size++] = 0;
+      while (stack_size > 0) {
+        const Node& node = nodes[stack[--stack_size]];
+        if (!node.box.contains(point)) {
+          continue;
+        }
+        if (node.count == 0) {
+          stack[stack_size++] = &node - &nodes[0] + 1;
+          stack[stack_size++] = node.offset;
+          continue;
+        }
+        for (int i = node.offset; i < node.offset + node.count; i++) {
+          const Entry& entry = entries[i];
+          Vector3D offset = point - entry.position;
+          if (offset[0] * offset[0] + offset[1] * offset[1] +
+                  offset[2] * offset[2] <=
+              entry.radius_squared) {
+            (entry.spot ? spot_lights : lights).push_back(entry.index);
+          }
+        }
+      }
+    }
+    sort(lights.begin(), lights.end());
+    sort(spot_lights.begin(), spot_lights.end());
+  }
+};
+
+#endif  // LIGHT_TREE_H
@@ -15,16 +15,18 @@ class Line {
   Vector3D direction;
 
  public:
+  Line() {}
+
   Line(Vector3D start, Vector3D direction) {
     this->start = start;
     direction.normalize();
     this->direction = direction;
   }
 
-  Vector3D getStart() { return start; }
-  Vector3D getDirection() { return direction; }
+  Vector3D getStart() const { return start; }
+  Vector3D getDirection() const { return direction; }
 
-  Vector3D getPoint(double t) { return start + direction * t; }
+  Vector3D getPoint(double t) const { return start + direction * t; }
 
   void setStart(Vector3D start) { this->start = start; }
 
@@ -8,214 +8,15 @@
 
 #include <GL/glut.h>  // GLUT, includes glu.h and gl.h
 
-// math library
-#include <cmath>
-#include <sstream>
-#include <string>
-#include <vector>
-
-#include "1805086_bitmap_image.hpp"
-#include "1805086_checker_board.cpp"
-#include "1805086_color.cpp"
-#include "1805086_cube.cpp"
-#include "1805086_light.cpp"
-#include "1805086_line.cpp"
-#include "1805086_pixel_line_map.cpp"
-#include "1805086_pyramid.cpp"
-#include "1805086_shape.cpp"
-#include "1805086_sphere.cpp"
-#include "1805086_spot_light.cpp"
-#include "1805086_triangle.cpp"
-#include "1805086_vector3d.cpp"
+#include "1805086_renderer.cpp"
 
 using namespace std;
 
 bool draw_axis_flag = true;
 
-// global variable
-// camera
-Vector3D camera;
-// look vector
-Vector3D look;
-// up vector
-Vector3D up;
-
 // test
 Triangle t;
 
-// parameters
-double near_plane, far_plane, fov_y, aspect_ratio;
-// level of recursion
-int level_of_recursion;
-// number of pixels
-int number_of_pixels_y;
-
-double width_of_cell;
-double ambient_coefficient, diffuse_coefficient, reflection_coefficient;
-
-int number_of_shapes;
-int number_of_normal_light_sources;
-int number_of_spot_light_sources;
-
-// vector of shapes
-vector<Shape*> shapes;
-vector<Light*> normal_light_sources;
-vector<SpotLight*> spot_light_sources;
-bitmap_image texture1;
-bitmap_image texture2;
-/**
- * This function captures the image
- * @param filename the name of the file to be saved
- */
-void capture_image(string filename, Color** frame_buffer) {
-  // create the image
-  bitmap_image image(number_of_pixels_y * aspect_ratio, number_of_pixels_y);
-  // capture the image
-  for (int i = 0; i < number_of_pixels_y * aspect_ratio; i++) {
-    for (int j = 0; j < number_of_pixels_y; j++) {
-      // set the color of the pixel
-      image.set_pixel(i, j, frame_buffer[i][j][0] * 255,
-                      frame_buffer[i][j][1] * 255, frame_buffer[i][j][2] * 255);
-    }
-  }
-  // save the image
-  image.save_image(filename.c_str());
-}
-/**
- * @brief This generates the lines from camera to each pixel
- * @return vector<Line> the vector of lines
- */
-vector<PixelLineMap> generate_lines() {
-  // calculate the x,y,z point for each pixel
-  // then generate the line from camera to that point
-  // we have look, camera and up vector
-  // generate looking direction by look - camera
-  // find right vector by cross product of looking direction and up vector
-  // find up vector by cross product of right vector and looking direction
-  // normalize all the vectors
-  Vector3D look_vec(look - camera);
-  Vector3D cross = look_vec * up;
-  Vector3D up_vec = cross * look_vec;
-  look_vec.normalize();
-  cross.normalize();
-  up_vec.normalize();
-  vector<PixelLineMap> map;
-  // calculate the mid point of the screen (near plane)
-  Vector3D mid_point = camera + look_vec * near_plane;
-
-  // calculate the height and width of the near plane
-  float screen_height = 2 * near_plane * tan(fov_y * M_PI / (2 * PI_DEGREE));
-  cout << "screen height : " << screen_height << endl;
-  float screen_width = screen_height * aspect_ratio;
-  cout << "screen width : " << screen_width << endl;
-
-  // calculate the step size
-  float step_x = screen_width / (number_of_pixels_y * aspect_ratio);
-  float step_y = screen_height / number_of_pixels_y;
-  for (int y = 0; y < number_of_pixels_y; y++) {
-    // calculate the y scale factor the range can be -screen_height/2 to
-    // +screen_height/2
-    float y_scale = -screen_height / 2 + step_y * y + step_y / 2;
-    // iterate over the x axis
-    for (int x = 0; x < number_of_pixels_y * aspect_ratio; x++) {
-      // calculate the x scale factor the range can be -screen_width/2 to
-      // +screen_width/2
-      float x_scale = -screen_width / 2 + step_x * x + step_x / 2;
-
-      // calculate the point on the near plane
-      Vector3D point = mid_point + cross * x_scale - up_vec * y_scale;
-
-      // generate the line from camera to the point
-      Vector3D direction = point - camera;
-      Line line(point, direction);
-      // create the pixel line map
-      PixelLineMap pixel_line_map(x, y, line);
-      // add the pixel line map to the vector
-      map.push_back(pixel_line_map);
-    }
-  }
-  return map;
-}
-
-/**
- * This function calculates the color of the pixel and returns it in frame
- * buffer
- * @return Color** the frame buffer
- */
-Color** generate_image() {
-  // create the frame buffer
-  Color** frame_buffer = new Color*[((int)(number_of_pixels_y * aspect_ratio))];
-  for (int i = 0; i < number_of_pixels_y * aspect_ratio; i++) {
-    frame_buffer[i] = new Color[number_of_pixels_y];
-  }
-
-  // generate the lines
-  vector<PixelLineMap> pixel_line_map = generate_lines();
-
-  cout << "lines generated.........." << endl;
-
-  // calculate the color of each pixel
-  // iterate over the lines
-  for (int i = 0; i < pixel_line_map.size(); i++) {
-    // get the line
-    PixelLineMap pixel_line = pixel_line_map[i];
-    Line line = pixel_line.getLine();
-    double progress = (double)i / pixel_line_map.size() * 100;
-    cout << "progress : " << fixed << setprecision(2) << progress << "%\r"
-         << flush;
-    // cout << "line : " << i << endl;
-    // line.print();
-
-    // find the nearest intersection point
-    double t_min = 1000000000;
-    int nearest_shape_index = -1;
-    for (int j = 0; j < shapes.size(); j++) {
-      // get the shape
-      Shape* shape = shapes[j];
-      // calculate the intersection point
-      Color color(0, 0, 0);
-      double t = shape->getT(line);
-      // cout << "x : " << pixel_line.getX() << " y : " << pixel_line.getY()
-      //      << " t : " << t << endl;
-      // check if the intersection point is valid
-      if (t > 0 && (nearest_shape_index == -1 || t < t_min)) {
-        // update the nearest shape index
-        nearest_shape_index = j;
-        // update the t_min
-        t_min = t;
-      }
-    }
-
-    // check if there is an intersection point
-    if (nearest_shape_index != -1) {
-      // get the shape
-      Shape* shape = shapes[nearest_shape_index];
-      // get the color
-      Color color(0, 0, 0);
-      // calculate the color
-      double t =
-          shape->intersect(line, normal_light_sources, spot_light_sources,
-                           shapes, color, 1, level_of_recursion);
-      // now we have the color
-      // set the color in the frame buffer
-      // sanity check for color
-      for (int i = 0; i < 3; i++) {
-        if (color[i] < 0) {
-          color[i] = 0;
-        }
-        if (color[i] > 1) {
-          color[i] = 1;
-        }
-      }
-
-      frame_buffer[pixel_line.getX()][pixel_line.getY()] = color;
-    }
-  }
-
-  // return the frame buffer
-  return frame_buffer;
-}
-
 /**
  * @brief draw_axis
  * draws the axis
@@ -253,261 +54,6 @@ void draw_axis() {
   }
 }
 
-/**
- * @brief Loads the data from the file
- * @param filename the name of the file
- */
-void load_parameters(string filename) {
-  // load the textures
-  texture1 = bitmap_image("texture_b.bmp");
-  texture2 = bitmap_image("texture_w.bmp");
-
-  ifstream file(filename.c_str());
-  string line;
-
-  // read near plane, far plane, fov_y, aspect_ratio from 1st line
-  getline(file, line);
-  stringstream ss(line);
-  ss >> near_plane >> far_plane >> fov_y >> aspect_ratio;
-  // read level of recursion from 2nd line
-  getline(file, line);
-  stringstream ss2(line);
-  ss2 >> level_of_recursion;
-  // read number of pixels from 3rd line
-  getline(file, line);
-  stringstream ss3(line);
-  ss3 >> number_of_pixels_y;
-  // width of each cell of checker board
-  getline(file, line);  // consume the empty line
-  getline(file, line);
-  stringstream ss4(line);
-  ss4 >> width_of_cell;
-  // ambient , diffuse and reflection coefficients for checker board
-  getline(file, line);
-  stringstream ss5(line);
-  ss5 >> ambient_coefficient >> diffuse_coefficient >> reflection_coefficient;
-  CheckerBoard* floor =
-      new CheckerBoard(Vector3D(0, 0, 0), Color(1, 1, 1), ambient_coefficient,
-                       diffuse_coefficient, 0, reflection_coefficient,
-                       width_of_cell, false, texture1, texture2);
-  floor->print();
-
-  // add the floor checker board to the shapes vector
-  shapes.push_back(floor);
-
-  // consume the empty line
-  getline(file, line);
-  // read the number of shapes
-  getline(file, line);
-  stringstream ss6(line);
-  ss6 >> number_of_shapes;
-  cout << "number of shapes : " << number_of_shapes << endl;
-  // consume the empty line
-  getline(file, line);
-  // read the shapes
-  for (int i = 0; i < number_of_shapes; i++) {
-    // read the shape type
-    getline(file, line);
-    stringstream ss7(line);
-    // cube is written in 'cube' format
-    // same for pyramid and sphere
-    string shape_type;
-    ss7 >> shape_type;
-    cout << "i : " << i << " shape type : " << shape_type << endl;
-
-    // switch case for different shapes
-    if (shape_type == "sphere") {
-      // read the position
-      getline(file, line);
-      stringstream ss8(line);
-      double x, y, z;
-      ss8 >> x >> y >> z;
-      Vector3D position(x, y, z);
-      // read the radius
-      getline(file, line);
-      stringstream ss9(line);
-      double radius;
-      ss9 >> radius;
-      // read the color
-      getline(file, line);
-      stringstream ss10(line);
-      float r, g, b;
-      ss10 >> r >> g >> b;
-      // convert the color to integer value between 0 and 255 (current range is
-      // 0 and 1)
-      Color color(r, g, b);
-      // read the ambient, diffuse and specular, reflection coefficients
-      getline(file, line);
-      stringstream ss11(line);
-      double ka, kd, ks, kr;
-      ss11 >> ka >> kd >> ks >> kr;
-      // read the specular exponent (shine)
-      getline(file, line);
-      stringstream ss12(line);
-      int shine;
-      ss12 >> shine;
-      // create the sphere
-      Sphere* sphere = new Sphere(position, color, ka, kd, ks, kr, shine,
-                                  radius);  // create the sphere
-      // add the sphere to the shapes vector
-      shapes.push_back(sphere);
-      cout << "sphere added" << endl;
-    } else if (shape_type == "pyramid") {
-      // read the position
-      getline(file, line);
-      stringstream ss8(line);
-      double x, y, z;
-      ss8 >> x >> y >> z;
-      Vector3D position(x, y, z);
-      // read width and height of base
-      getline(file, line);
-      stringstream ss9(line);
-      double width, height;
-      ss9 >> width >> height;
-
-      // read the color
-      getline(file, line);
-      stringstream ss10(line);
-      float r, g, b;
-      ss10 >> r >> g >> b;
-      Color color(r, g, b);
-      // read the ambient, diffuse and specular, reflection coefficients
-      getline(file, line);
-      stringstream ss11(line);
-      double ka, kd, ks, kr;
-      ss11 >> ka >> kd >> ks >> kr;
-      // read the specular exponent (shine)
-      getline(file, line);
-      stringstream ss12(line);
-      int shine;
-      ss12 >> shine;
-      cout << "creating pyramid" << endl;
-      //  create the pyramid
-      Pyramid* pyramid =
-          new Pyramid(position, color, ka, kd, ks, kr, shine, width, height);
-      // add the pyramid to the shapes vector
-      shapes.push_back(pyramid);
-    } else if (shape_type == "cube") {
-      // read the position
-      getline(file, line);
-      stringstream ss8(line);
-      double x, y, z;
-      ss8 >> x >> y >> z;
-      Vector3D position(x, y, z);
-      // read the length of each side of the cube
-      getline(file, line);
-      stringstream ss9(line);
-      double length;
-      ss9 >> length;
-      // read the color
-      getline(file, line);
-      stringstream ss10(line);
-      float r, g, b;
-      ss10 >> r >> g >> b;
-      // convert the color to integer value between 0 and 255 (current range is
-      // 0 and 1)
-      Color color(r, g, b);
-      // read the ambient, diffuse and specular, reflection coefficients
-      getline(file, line);
-      stringstream ss11(line);
-      double ka, kd, ks, kr;
-      ss11 >> ka >> kd >> ks >> kr;
-      // read the specular exponent (shine)
-      getline(file, line);
-      stringstream ss12(line);
-      int shine;
-      ss12 >> shine;
-      cout << "creating cube" << endl;
-      // create the cube
-      Cube* cube = new Cube(position, color, ka, kd, ks, kr, shine, length);
-      // add the cube to the shapes vector
-      shapes.push_back(cube);
-    }
-
-    // consume the empty line
-    getline(file, line);
-  }
-
-  // capture information about light sources
-  // read the number of normal light sources
-  getline(file, line);
-  stringstream ss13(line);
-  ss13 >> number_of_normal_light_sources;
-  cout << "number of normal light sources : " << number_of_normal_light_sources
-       << endl;
-  // read the normal light sources
-  for (int i = 0; i < number_of_normal_light_sources; i++) {
-    // read the position
-    getline(file, line);
-    stringstream ss14(line);
-    double x, y, z;
-    ss14 >> x >> y >> z;
-    Vector3D position(x, y, z);
-    // read the fall of parameter
-    getline(file, line);
-    stringstream ss15(line);
-    double fall_of_parameter;
-    ss15 >> fall_of_parameter;
-    // create the light source (color is white)
-    Light* light = new Light(position, Color(1, 1, 1), fall_of_parameter);
-    // add the light source to the vector
-    normal_light_sources.push_back(light);
-    // consume the empty line
-    getline(file, line);
-    cout << "normal light source parameter" << endl;
-    position.print();
-    cout << fall_of_parameter << endl;
-  }
-  // read the number of spot light sources
-  getline(file, line);
-  stringstream ss16(line);
-  ss16 >> number_of_spot_light_sources;
-  cout << "number of spot light sources : " << number_of_spot_light_sources
-       << endl;
-  // read the spot light sources
-  for (int i = 0; i < number_of_spot_light_sources; i++) {
-    // read the position
-    getline(file, line);
-    stringstream ss17(line);
-    double x, y, z;
-    ss17 >> x >> y >> z;
-    Vector3D position(x, y, z);
-    // read the fall of parameter
-    getline(file, line);
-    stringstream ss18(line);
-    double fall_of_parameter;
-    ss18 >> fall_of_parameter;
-    // read the point to which the spot light is looking
-    getline(file, line);
-    stringstream ss19(line);
-    double x1, y1, z1, angle;
-    ss19 >> x1 >> y1 >> z1 >> angle;
-    Vector3D pointing(x1, y1, z1);
-    // calculate the direction vector
-    Vector3D direction = pointing - position;
-    // normalize the direction vector
-    direction.normalize();
-
-    // create the spot light source (color is white)
-    SpotLight* spot_light = new SpotLight(position, Color(1, 1, 1),
-                                          fall_of_parameter, direction, angle);
-    // add the spot light source to the vector
-    spot_light_sources.push_back(spot_light);
-    // consume the empty line
-    getline(file, line);
-    cout << "spot light source parameter" << endl;
-    position.print();
-    cout << fall_of_parameter << endl;
-    direction.print();
-    cout << angle << endl;
-  }
-
-  // close the file
-  file.close();
-  cout << "normal light sources : " << normal_light_sources.size() << endl;
-  cout << "spot light sources : " << spot_light_sources.size() << endl;
-  cout << "shapes : " << shapes.size() << endl;
-}
 
 /* Initialize OpenGL Graphics */
 void initGL() {
@@ -584,7 +130,7 @@ void key_pressed(unsigned char key, int x, int y) {
   float rate_translation = 0.1;
   // calculate the look vector
   Vector3D look_vec(look - camera);
-  Color** frame_buffer;
+  FrameBuffer* frame_buffer;
 
   // normalize the up vector and look vector
   up.normalize();
@@ -659,8 +205,25 @@ void key_pressed(unsigned char key, int x, int y) {
       frame_buffer = generate_image();
       cout << "frame buffer generated" << endl;
       // save the image
-      capture_image("output.bmp", frame_buffer);
-      cout << "image captured" << endl;
+      if (capture_image("output.bmp", frame_buffer)) {
+        cout << "image captured" << endl;
+      } else {
+        cerr << "cannot write output.bmp" << endl;
+      }
+      delete frame_buffer;
+      // report what the frame cost
+      frame_statistics.print(cout);
+      if (!save_statistics("output_statistics.json")) {
+        cerr << "cannot write output_statistics.json" << endl;
+      }
+      if (!save_cost_image("output_cost.bmp")) {
+        cerr << "cannot write output_cost.bmp" << endl;
+      }
+      break;
+    case 'c':
+      // toggle recording the cost of every pixel with the next image
+      record_pixel_costs = !record_pixel_costs;
+      cout << "record pixel costs : " << record_pixel_costs << endl;
       break;
     case ' ':
       // toggle the texture mode
@@ -752,8 +315,16 @@ void special_key_pressed(int key, int x, int y) {
 
 /* Main function: GLUT runs as a console application starting at main()  */
 int main(int argc, char** argv) {
+  glutInit(&argc, argv);  // Initialize GLUT, which takes its own arguments
+  // the number of threads can be passed as the first argument, it is parsed
+  // before the scene is loaded because the BVH is built with them too
+  if (argc > 1) {
+    number_of_threads = max(1, atoi(argv[1]));
+  }
+  cout << "render threads : " << number_of_threads << endl;
   // load the parameters
   load_parameters("scene.txt");
+  build_acceleration_structure();
   // initialize the camera
   look[0] = 0;
   look[1] = 0;
@@ -764,8 +335,7 @@ int main(int argc, char** argv) {
   up[0] = 0;
   up[1] = 0;
   up[2] = 1;
-  glutInit(&argc, argv);  // Initialize GLUT
-  int window_width = number_of_pixels_y * aspect_ratio;
+  int window_width = get_image_width();
   glutInitWindowSize(
       window_width,
       number_of_pixels_y);         // Set the window's initial width & height
@@ -0,0 +1,127 @@
+/**
+ * @file mapped_file.cpp
+ * @brief This file contains a read only file mapped into memory
+ * the binary scenes and the scene caches are read in place through it. where
+ * mmap is not available the file is read into a buffer instead.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_MMAP
+#endif
+
+using namespace std;
+
+/**
+ * @brief The MappedFile class
+ * the contents stay valid until the file is closed or destroyed
+ */
+class MappedFile {
+ private:
+  const char* data;
+  size_t size;
+  bool mapped;
+  // the file is read into this buffer where it cannot be mapped
+  vector<char> buffer;
+
+ public:
+  MappedFile() : data(NULL), size(0), mapped(false) {}
+  ~MappedFile() { close(); }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   * @brief maps a whole file
+   * @return false if the file cannot be read
+   */
+  bool open(const string& filename) {
+    close();
+#ifdef MAPPED_FILE_MMAP
+    int file = ::open(filename.c_str(), O_RDONLY);
+    struct stat status;
+    if (file < 0 || fstat(file, &status) != 0) {
+      if (file >= 0) {
+        ::close(file);
+      }
+      return false;
+    }
+    size = status.st_size;
+    if (size > 0) {
+      void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+      mapped = mapping != MAP_FAILED;
+      data = mapped ? (const char*)mapping : NULL;
+    } else {
+      data = "";
+    }
+    ::close(file);
+    if (data == NULL) {
+      size = 0;
+      return false;
+    }
+#else
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (file == NULL) {
+      return false;
+    }
+    fseek(file, 0, SEEK_END);
+    buffer.resize(max(0L, ftell(file)));
+    fseek(file, 0, SEEK_SET);
+    size = fread(buffer.data(), 1, buffer.size(), file);
+    fclose(file);
+    data = size > 0 ? buffer.data() : "";
+#endif
+    return true;
+  }
+
+  /**
+   * @brief unmaps the file
+   */
+  void close() {
+#ifdef MAPPED_FILE_MMAP
+    if (mapped) {
+      munmap((void*)data, size);
+    }
+#endif
+    buffer.clear();
+    data = NULL;
+    size = 0;
+    mapped = false;
+  }
+
+  const char* getData() const { return data; }
+  size_t getSize() const { return size; }
+};
+
+/**
+ * @brief writes a file through a temporary file that replaces it once it is
+ * complete, so that a reader never sees half of it
+ * @return false if the file cannot be written
+ */
+bool write_whole_file(const string& filename, const vector<char>& contents) {
+  string temporary = filename + ".tmp";
+  FILE* file = fopen(temporary.c_str(), "wb");
+  if (file == NULL) {
+    return false;
+  }
+  bool written =
+      fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+  written = fclose(file) == 0 && written;
+  if (!written || rename(temporary.c_str(), filename.c_str()) != 0) {
+    remove(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+#endif  // MAPPED_FILE_H
@@ -0,0 +1,283 @@
+/**
+ * @file math_benchmark.cpp
+ * @brief This file contains the benchmark of the shading math
+ * checks fast_exp, int_pow and the cone test of the spot lights against
+ * what they replace (exp, pow and the angle in degrees) and prints the worst
+ * error and the time per call of each, as one JSON object per function. it
+ * exits with 1 if an error is beyond its bound.
+ *
+ * g++ -O2 -DHEADLESS 1805086_math_benchmark.cpp -o math_benchmark
+ * ./math_benchmark [number of repetitions, default 5]
+ */
+
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "1805086_fast_math.cpp"
+#include "1805086_spot_light.cpp"
+
+using namespace std;
+
+// the values of a timed loop are added up here so it is not optimized away
+volatile double sink;
+
+/**
+ * @brief the best time of a number of repetitions in ns per value
+ */
+template <typename Function>
+double best_ns(int repetitions, int values, Function function) {
+  double best = INFINITY;
+  for (int i = 0; i < repetitions; i++) {
+    auto start = chrono::steady_clock::now();
+    function();
+    auto end = chrono::steady_clock::now();
+    best = min(best, chrono::duration<double, nano>(end - start).count());
+  }
+  return best / values;
+}
+
+double relative_error(double value, double expected) {
+  if (value == expected) {
+    return 0;
+  }
+  return fabs(value - expected) / fabs(expected);
+}
+
+/**
+ * @brief fast_exp of the values one at a time and four at a time
+ */
+void fast_exp_all(const vector<double>& x,
+                  vector<double>& scalar,
+                  vector<double>& wide) {
+  for (int i = 0; i < x.size(); i++) {
+    scalar[i] = fast_exp(x[i]);
+  }
+  for (int i = 0; i + SIMD_WIDTH <= x.size(); i += SIMD_WIDTH) {
+    fast_exp(Double4::load(&x[i])).store(&wide[i]);
+  }
+}
+
+/**
+ * @brief the worst error of fast_exp over values uniform in [low, high], and
+ * whether the scalar and the Double4 version agree on every value
+ */
+bool check_exp(const char* name,
+               double low,
+               double high,
+               int repetitions,
+               mt19937_64& random) {
+  const int count = 1 << 20;
+  uniform_real_distribution<double> distribution(low, high);
+  vector<double> x(count), scalar(count), wide(count);
+  for (int i = 0; i < count; i++) {
+    x[i] = distribution(random);
+  }
+  fast_exp_all(x, scalar, wide);
+
+  double max_error = 0;
+  bool identical = true;
+  for (int i = 0; i < count; i++) {
+    max_error = max(max_error, relative_error(scalar[i], exp(x[i])));
+    identical = identical && memcmp(&scalar[i], &wide[i], sizeof(double)) == 0;
+  }
+
+  double libm_ns = best_ns(repetitions, count, [&]() {
+    double sum = 0;
+    for (int i = 0; i < count; i++) {
+      sum += exp(x[i]);
+    }
+    sink = sum;
+  });
+  double scalar_ns = best_ns(repetitions, count, [&]() {
+    double sum = 0;
+    for (int i = 0; i < count; i++) {
+      sum += fast_exp(x[i]);
+    }
+    sink = sum;
+  });
+  double wide_ns = best_ns(repetitions, count, [&]() {
+    Double4 sum(0.0);
+    for (int i = 0; i < count; i += SIMD_WIDTH) {
+      sum = sum + fast_exp(Double4::load(&x[i]));
+    }
+    double lanes[SIMD_WIDTH];
+    sum.store(lanes);
+    sink = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  });
+
+  bool passed = max_error <= FAST_EXP_MAX_ERROR && identical;
+  cout << "{\"function\": \"" << name << "\", \"low\": " << low
+       << ", \"high\": " << high << ", \"max_relative_error\": " << max_error
+       << ", \"bound\": " << FAST_EXP_MAX_ERROR
+       << ", \"scalar_equals_simd\": " << (identical ? "true" : "false")
+       << ", \"libm_ns\": " << libm_ns << ", \"scalar_ns\": " << scalar_ns
+       << ", \"simd_ns\": " << wide_ns
+       << ", \"passed\": " << (passed ? "true" : "false") << "}" << endl;
+  return passed;
+}
+
+/**
+ * @brief the arguments outside the range of fast_exp
+ */
+bool check_exp_limits() {
+  double x[] = {-INFINITY, -1000, -708.5, FAST_EXP_MIN, 0,
+                FAST_EXP_MAX, 709.8, 1000, INFINITY, NAN};
+  double expected[] = {0, 0, 0, exp(FAST_EXP_MIN), 1,
+                       exp(FAST_EXP_MAX), INFINITY, INFINITY, INFINITY, NAN};
+  int count = sizeof(x) / sizeof(x[0]);
+  bool passed = true;
+  for (int i = 0; i < count; i++) {
+    double lanes[SIMD_WIDTH];
+    fast_exp(Double4(x[i])).store(lanes);
+    double values[] = {fast_exp(x[i]), lanes[0]};
+    for (double value : values) {
+      if (isnan(expected[i])) {
+        passed = passed && isnan(value);
+      } else {
+        passed = passed &&
+                 relative_error(value, expected[i]) <= FAST_EXP_MAX_ERROR;
+      }
+    }
+  }
+  cout << "{\"function\": \"fast_exp limits\", \"passed\": "
+       << (passed ? "true" : "false") << "}" << endl;
+  return passed;
+}
+
+/**
+ * @brief int_pow against pow for the bases of the phong term, every
+ * squaring can at most double the error, so it stays below 2 n ulps
+ */
+bool check_int_pow(int repetitions, mt19937_64& random) {
+  const int count = 1 << 20;
+  uniform_real_distribution<double> distribution(0, 1);
+  vector<double> base(count);
+  vector<int> exponent(count);
+  for (int i = 0; i < count; i++) {
+    base[i] = distribution(random);
+    exponent[i] = i % 201;
+  }
+
+  double max_error = 0;
+  bool passed = true;
+  for (int i = 0; i < count; i++) {
+    double expected = pow(base[i], exponent[i]);
+    // results below the normal range only have an absolute error
+    if (expected < DBL_MIN) {
+      passed = passed && fabs(int_pow(base[i], exponent[i]) - expected) <=
+                             DBL_MIN * exponent[i] * DBL_EPSILON;
+      continue;
+    }
+    double error = relative_error(int_pow(base[i], exponent[i]), expected);
+    max_error = max(max_error, error);
+    passed = passed && error <= 2 * max(1, exponent[i]) * DBL_EPSILON;
+  }
+  passed = passed && int_pow(2, -3) == 0.125 && int_pow(0, 0) == 1 &&
+           int_pow(-2, 3) == -8 && int_pow(0, -1) == INFINITY;
+
+  double libm_ns = best_ns(repetitions, count, [&]() {
+    double sum = 0;
+    for (int i = 0; i < count; i++) {
+      sum += pow(base[i], exponent[i]);
+    }
+    sink = sum;
+  });
+  double fast_ns = best_ns(repetitions, count, [&]() {
+    double sum = 0;
+    for (int i = 0; i < count; i++) {
+      sum += int_pow(base[i], exponent[i]);
+    }
+    sink = sum;
+  });
+
+  cout << "{\"function\": \"int_pow\", \"max_exponent\": 200"
+       << ", \"max_relative_error\": " << max_error
+       << ", \"libm_ns\": " << libm_ns << ", \"fast_ns\": " << fast_ns
+       << ", \"passed\": " << (passed ? "true" : "false") << "}" << endl;
+  return passed;
+}
+
+/**
+ * @brief SpotLight::isInCone against the angle in degrees, they may only
+ * disagree for points within 1e-6 degrees of the edge of the cone
+ */
+bool check_cone(int repetitions, mt19937_64& random) {
+  const int count = 1 << 18;
+  uniform_real_distribution<double> coordinate(-100, 100);
+  uniform_real_distribution<double> degrees(-10, 200);
+  vector<SpotLight> spot_lights;
+  vector<Vector3D> to_point(count);
+  vector<double> distance(count);
+  for (int i = 0; i < 64; i++) {
+    Vector3D direction(coordinate(random), coordinate(random),
+                       coordinate(random));
+    spot_lights.push_back(
+        SpotLight(Vector3D(), Color(1, 1, 1), 1, direction, degrees(random)));
+  }
+  for (int i = 0; i < count; i++) {
+    to_point[i] =
+        Vector3D(coordinate(random), coordinate(random), coordinate(random));
+    distance[i] = to_point[i].length();
+  }
+
+  int disagreements = 0;
+  bool passed = true;
+  for (int i = 0; i < count; i++) {
+    SpotLight& spot_light = spot_lights[i % spot_lights.size()];
+    double angle = spot_light.getDirection().angle(to_point[i]) * 180 / M_PI;
+    bool outside = angle > spot_light.getAngle();
+    if (spot_light.isInCone(to_point[i], distance[i]) == outside) {
+      disagreements++;
+      passed = passed && fabs(angle - spot_light.getAngle()) < 1e-6;
+    }
+  }
+  // the point at the light and a light without a direction, both light it
+  passed = passed && spot_lights[0].isInCone(Vector3D(), 0) &&
+           SpotLight(Vector3D(), Color(1, 1, 1), 1, Vector3D(), 30)
+               .isInCone(Vector3D(1, 0, 0), 1);
+
+  double angle_ns = best_ns(repetitions, count, [&]() {
+    int inside = 0;
+    for (int i = 0; i < count; i++) {
+      SpotLight& spot_light = spot_lights[i % spot_lights.size()];
+      double angle = spot_light.getDirection().angle(to_point[i]);
+      inside += !(angle * 180 / M_PI > spot_light.getAngle());
+    }
+    sink = inside;
+  });
+  double cone_ns = best_ns(repetitions, count, [&]() {
+    int inside = 0;
+    for (int i = 0; i < count; i++) {
+      inside += spot_lights[i % spot_lights.size()].isInCone(to_point[i],
+                                                            distance[i]);
+    }
+    sink = inside;
+  });
+
+  cout << "{\"function\": \"cone test\", \"disagreements\": " << disagreements
+       << ", \"angle_ns\": " << angle_ns << ", \"cosine_ns\": " << cone_ns
+       << ", \"passed\": " << (passed ? "true" : "false") << "}" << endl;
+  return passed;
+}
+
+int main(int argc, char** argv) {
+  int repetitions = argc > 1 ? max(1, atoi(argv[1])) : 5;
+  mt19937_64 random(1805086);
+
+  bool passed = true;
+  // the attenuation of the shading is always in this range
+  passed = check_exp("fast_exp", -50, 0, repetitions, random) && passed;
+  passed = check_exp("fast_exp", FAST_EXP_MIN, FAST_EXP_MAX, repetitions,
+                     random) &&
+           passed;
+  passed = check_exp_limits() && passed;
+  passed = check_int_pow(repetitions, random) && passed;
+  passed = check_cone(repetitions, random) && passed;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file parse_benchmark.cpp
+ * @brief This file contains the scene parser benchmark
+ * parses generated scenes of increasing size and prints the throughput of
+ * the parser alone and of loading the scene (parsing and creating the shapes)
+ * in MB/s, as one JSON object per scene.
+ *
+ * g++ -O2 -DHEADLESS 1805086_parse_benchmark.cpp -o parse_benchmark -pthread
+ * ./parse_benchmark [number of repetitions, default 5]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "1805086_renderer.cpp"
+#include "1805086_scene_generator.cpp"
+
+using namespace std;
+
+/**
+ * @brief the best time of a number of repetitions in ms
+ */
+template <typename Function>
+double best_ms(int repetitions, Function function) {
+  double best = INFINITY;
+  for (int i = 0; i < repetitions; i++) {
+    auto start = chrono::steady_clock::now();
+    function();
+    auto end = chrono::steady_clock::now();
+    best = min(best, chrono::duration<double, milli>(end - start).count());
+  }
+  return best;
+}
+
+double megabytes_per_second(size_t bytes, double ms) {
+  return bytes / 1e6 / (ms / 1000);
+}
+
+int main(int argc, char** argv) {
+  int repetitions = argc > 1 ? max(1, atoi(argv[1])) : 5;
+  int sizes[] = {1000, 10000, 100000};
+
+  for (int number_of_shapes : sizes) {
+    int each = number_of_shapes / 3;
+    SceneGenerator generator(number_of_shapes, each, each,
+                             number_of_shapes - 2 * each, 8, 4);
+    ostringstream text;
+    generator.write(text, 720, 3);
+    string scene_text = text.str();
+
+    SceneParser parser;
+    SceneDescription scene;
+    double parse_ms = best_ms(repetitions, [&]() {
+      parser.parse(scene_text.data(), scene_text.data() + scene_text.size(),
+                   scene);
+    });
+    if (!parser.getError().empty()) {
+      cerr << parser.getError() << endl;
+      return 1;
+    }
+
+    // the whole load goes through a file, as the renderer reads it
+    string filename = "parse_benchmark.txt";
+    {
+      ofstream file(filename.c_str());
+      file << scene_text;
+    }
+    streambuf* console = cout.rdbuf(NULL);
+    bool loaded = true;
+    double load_ms = best_ms(repetitions, [&]() {
+      clear_scene();
+      loaded = load_parameters(filename) && loaded;
+    });
+    clear_scene();
+    cout.rdbuf(console);
+    cout.clear();
+    remove(filename.c_str());
+    if (!loaded) {
+      return 1;
+    }
+
+    cout << "{\"shapes\": " << number_of_shapes
+         << ", \"bytes\": " << scene_text.size()
+         << ", \"parse_ms\": " << parse_ms << ", \"parse_mb_per_second\": "
+         << megabytes_per_second(scene_text.size(), parse_ms)
+         << ", \"load_ms\": " << load_ms << ", \"load_mb_per_second\": "
+         << megabytes_per_second(scene_text.size(), load_ms) << "}" << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,52 @@
+/**
+ * @file parser_check.cpp
+ * @brief This file contains the check of the numbers the scene parser takes
+ * the near plane of a small scene is written in different ways, the scene
+ * has to be read with the right value or rejected. it prints one JSON object
+ * per case and exits with 1 if any is not handled as expected.
+ *
+ * g++ -O2 -DHEADLESS 1805086_parser_check.cpp -o parser_check -pthread
+ * ./parser_check
+ */
+
+#include <iostream>
+#include <string>
+
+#include "1805086_scene_parser.cpp"
+
+using namespace std;
+
+/**
+ * @brief a way of writing the near plane and what it has to be read as
+ */
+struct NumberCase {
+  string text;
+  bool valid;
+  double value;
+};
+
+int main() {
+  NumberCase cases[] = {{"1", true, 1},     {"+1", true, 1},
+                        {"-1", true, -1},   {"+2.5e+1", true, 25},
+                        {"+.5", true, 0.5}, {"+-1", false, 0},
+                        {"++1", false, 0},  {"+", false, 0},
+                        {"+ 1", false, 0},  {"1+", false, 0}};
+  bool passed = true;
+  for (const NumberCase& number : cases) {
+    string scene_text = number.text +
+                        " 1000 80 1\n3\n100\n\n10\n+0.1 0.3 0.6\n\n0\n\n"
+                        "0\n\n0\n";
+    SceneParser parser;
+    SceneDescription scene;
+    bool valid = parser.parse(scene_text.data(),
+                              scene_text.data() + scene_text.size(), scene);
+    bool handled = valid == number.valid &&
+                   (!valid || (scene.near_plane == number.value &&
+                               scene.ambient_coefficient == 0.1));
+    passed = passed && handled;
+    cout << "{\"near_plane\": \"" << number.text
+         << "\", \"valid\": " << (valid ? "true" : "false")
+         << ", \"handled\": " << (handled ? "true" : "false") << "}" << endl;
+  }
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file progress_reporter.cpp
+ * @brief This file contains the progress reporter of the renderer
+ * the render threads only increment an atomic counter of completed tiles, a
+ * separate reporter thread samples it at a fixed interval and does all the
+ * formatting and printing, so reporting never holds up a render thread.
+ */
+
+#ifndef PROGRESS_REPORTER_H
+#define PROGRESS_REPORTER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+/**
+ * @brief how the progress is reported
+ */
+enum ProgressMode {
+  PROGRESS_QUIET,    // nothing is printed
+  PROGRESS_CONSOLE,  // a percentage that is overwritten in place
+  PROGRESS_JSON      // one JSON object per line, for scripts
+};
+
+/**
+ * @brief The ProgressReporter class
+ * reports from construction until finish() (or destruction)
+ */
+class ProgressReporter {
+ private:
+  atomic<int> completed;
+  int total;
+  ProgressMode mode;
+  ostream& out;
+  chrono::milliseconds interval;
+  chrono::steady_clock::time_point start;
+
+  mutex lock;
+  condition_variable wake;
+  bool finished;
+  thread reporter;
+
+  /**
+   * @brief print the progress as it is now
+   * the line is formatted on its own stream, so the formatting of out is left
+   * as the caller set it
+   */
+  void report(bool last) {
+    int done = completed.load(memory_order_relaxed);
+    double percent = total == 0 ? 100 : (double)done / total * 100;
+    ostringstream line;
+    line << fixed << setprecision(2);
+    if (mode == PROGRESS_CONSOLE) {
+      line << "progress : " << percent << "%" << (last ? "\n" : "\r");
+    } else if (mode == PROGRESS_JSON) {
+      double elapsed_ms = chrono::duration<double, milli>(
+                              chrono::steady_clock::now() - start)
+                              .count();
+      line << "{\"completed\": " << done << ", \"total\": " << total
+           << ", \"percent\": " << percent
+           << ", \"elapsed_ms\": " << elapsed_ms << "}\n";
+    }
+    out << line.str() << flush;
+  }
+
+  /**
+   * @brief the reporter thread, reports every interval until finished
+   */
+  void run() {
+    unique_lock<mutex> guard(lock);
+    while (!wake.wait_for(guard, interval, [this] { return finished; })) {
+      report(false);
+    }
+  }
+
+ public:
+  /**
+   * @brief start reporting
+   * @param total the number of steps of the work
+   * @param mode how the progress is reported
+   * @param out the stream the progress is printed to
+   * @param interval_ms the time between two reports
+   */
+  ProgressReporter(int total, ProgressMode mode, ostream& out, int interval_ms)
+      : completed(0),
+        total(total),
+        mode(mode),
+        out(out),
+        interval(interval_ms),
+        start(chrono::steady_clock::now()),
+        finished(false) {
+    if (mode != PROGRESS_QUIET) {
+      reporter = thread(&ProgressReporter::run, this);
+    }
+  }
+
+  ~ProgressReporter() { finish(); }
+
+  // the reporter thread refers to the object, so it is not copied
+  ProgressReporter(const ProgressReporter&) = delete;
+  ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+  /**
+   * @brief count completed steps, called by the workers
+   */
+  void advance(int steps) { completed.fetch_add(steps, memory_order_relaxed); }
+
+  /**
+   * @brief stop the reporter thread and report the final progress
+   */
+  void finish() {
+    if (!reporter.joinable()) {
+      return;
+    }
+    {
+      lock_guard<mutex> guard(lock);
+      finished = true;
+    }
+    wake.notify_one();
+    reporter.join();
+    report(true);
+  }
+};
+
+#endif  // PROGRESS_REPORTER_H
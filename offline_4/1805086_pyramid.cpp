@@ -7,19 +7,25 @@
 #ifndef PYRAMID_H
 #define PYRAMID_H
 
+#ifndef HEADLESS
 #include <GL/glut.h>  // GLUT, includes glu.h and gl.h
+#endif
 #include <vector>
 
+#include "1805086_bvh.cpp"
 #include "1805086_line.cpp"
 #include "1805086_shape.cpp"
 #include "1805086_triangle.cpp"
+#include "1805086_triangle_batch.cpp"
 #include "1805086_vector3d.cpp"
 
 class Pyramid : public Shape {
  private:
-  double baseSideLength;        // side length of the pyramid's base
-  double height;                // height of the pyramid
-  vector<Triangle*> triangles;  // vector of triangles that make up the pyramid
+  double baseSideLength;         // side length of the pyramid's base
+  double height;                 // height of the pyramid
+  vector<Triangle*> triangles;   // vector of triangles that make up the pyramid
+  BVH triangle_bvh;              // bottom level hierarchy for packets of rays
+  TriangleBatch triangle_batch;  // the triangles for single rays
 
  public:
   // Constructor to match the parent class
@@ -69,11 +75,24 @@ class Pyramid : public Shape {
             specular_coefficient, reflection_coefficient, specular_exponent));
       }
     }
+    triangle_bvh = BVH(vector<Shape*>(triangles.begin(), triangles.end()));
+    triangle_batch = TriangleBatch(triangles);
   }
 
   // Empty constructor
   Pyramid() : Shape(), baseSideLength(0), height(0) {}
 
+  // Destructor, the triangles are owned by the pyramid
+  ~Pyramid() {
+    for (int i = 0; i < triangles.size(); i++) {
+      delete triangles[i];
+    }
+  }
+
+  // the triangles are owned, so a copy would delete them twice
+  Pyramid(const Pyramid&) = delete;
+  Pyramid& operator=(const Pyramid&) = delete;
+
   // Getter and setter for the base side length
   double getBaseSideLength() { return baseSideLength; }
   void setBaseSideLength(double baseSideLength) {
@@ -84,52 +103,71 @@ class Pyramid : public Shape {
   double getHeight() { return height; }
   void setHeight(double height) { this->height = height; }
 
-  // Method to get the normal vector at an intersection point
-  Line getNormal(Vector3D& intersection_point, Line line) {
-    // first find the triangle that contains the intersection point
-    Triangle* triangle = NULL;
-    for (int i = 0; i < triangles.size(); i++) {
-      if (triangles[i]->inside(intersection_point)) {
-        triangle = triangles[i];
-        break;
-      }
+  // Method to calculate the intersection point of the line with the pyramid
+  double getT(Line& line) {
+    double t;
+    if (triangle_batch.closestHitIndex(line, 0, INFINITY, t) == -1) {
+      return -1;
     }
-    // it is guranteed to find a triangle as this is called only when the
-    // intersection point is inside the pyramid
-    return triangle->getNormal(intersection_point, line);
+    return t;
   }
 
-  // Method to calculate the intersection point of the line with the pyramid
-  double getT(Line& line) {
-    // find the intersection with each triangle
-    double t = -1;
-    for (int i = 0; i < triangles.size(); i++) {
-      double t1 = triangles[i]->getT(line);
-      if (t1 > 0) {
-        if (t == -1) {
-          t = t1;
-        } else {
-          t = min(t, t1);
-        }
+  // Method to find the hit of the line with the pyramid, the nearest triangle
+  // is found in the batch and then fills in the record
+  bool intersect(Line& line, double t_min, double t_max, HitRecord& hit) {
+    double t;
+    int primitive = triangle_batch.closestHitIndex(line, t_min, t_max, t);
+    if (primitive == -1 ||
+        !triangles[primitive]->intersect(line, t_min, t_max, hit)) {
+      return false;
+    }
+    hit.primitive = primitive;
+    return true;
+  }
+
+  // Method to check if the line hits the pyramid with 0 < t < t_max, stops at
+  // the first triangle that is hit
+  bool occluded(Line& line, double t_max) {
+    return triangle_batch.occluded(line, t_max);
+  }
+
+  // Method to calculate the intersection points of a packet of rays
+  void getT(RayPacket& packet, double t[SIMD_WIDTH]) {
+    int primitive[SIMD_WIDTH];
+    triangle_bvh.closestHitIndex(packet, primitive, t);
+    for (int i = 0; i < SIMD_WIDTH; i++) {
+      if (primitive[i] == -1) {
+        t[i] = -1;
       }
     }
+  }
 
-    // return the minimum t
-    return t;
+  // Method to get the kind of the shape
+  ShapeType getType() { return SHAPE_PYRAMID; }
+
+  // Method to get the bounding box of the pyramid
+  AABB getBoundingBox() {
+    AABB box;
+    for (int i = 0; i < triangles.size(); i++) {
+      box.expand(triangles[i]->getBoundingBox());
+    }
+    return box;
   }
 
   // Method to draw the pyramid
   void draw() {
+#ifndef HEADLESS
     // Set the color of the pyramid
     glColor3f(color[0], color[1], color[2]);
     // draw the pyramid using your chosen drawing method
     for (int i = 0; i < triangles.size(); i++) {
       triangles[i]->draw();
     }
+#endif
   }
 
   // Method to get the color at an intersection point
-  Color getColorAt(Vector3D& intersection_point) {
+  Color getColorAt(Vector3D& /*intersection_point*/) {
     // The color of the pyramid is the color of the pyramid
     return color;
   }
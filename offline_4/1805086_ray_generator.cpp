@@ -0,0 +1,104 @@
+/**
+ * @file ray_generator.cpp
+ * @brief This file contains the primary ray generator
+ * the camera basis and the near plane are computed once, the line from the
+ * camera through a pixel is then computed when the pixel is shaded, so no
+ * per pixel state is kept for the whole frame.
+ */
+
+#ifndef RAY_GENERATOR_H
+#define RAY_GENERATOR_H
+
+#include <cmath>
+
+#include "1805086_line.cpp"
+#include "1805086_pixel_line_map.cpp"
+#include "1805086_vector3d.cpp"
+
+#ifndef PI_DEGREE
+#define PI_DEGREE 180.0
+#endif
+
+using namespace std;
+
+/**
+ * @brief The RayGenerator class
+ * pixel (0, 0) is the top left corner of the image
+ */
+class RayGenerator {
+ private:
+  Vector3D camera;
+  Vector3D mid_point;  // center of the screen (near plane)
+  Vector3D right;      // unit vector along the rows of the screen
+  Vector3D up;         // unit vector along the columns of the screen
+  float screen_width, screen_height;
+  float step_x, step_y;
+
+ public:
+  /**
+   * @brief set up the screen of a camera
+   * @param camera the position of the camera
+   * @param look the point the camera looks at
+   * @param up the up vector of the camera
+   * @param near_plane the distance of the screen from the camera
+   * @param fov_y the vertical field of view in degrees
+   * @param aspect_ratio width / height of the screen
+   * @param number_of_pixels_y the number of pixels along the y axis
+   */
+  RayGenerator(Vector3D camera,
+               Vector3D look,
+               Vector3D up,
+               double near_plane,
+               double fov_y,
+               double aspect_ratio,
+               int number_of_pixels_y)
+      : camera(camera) {
+    // generate looking direction by look - camera
+    // find right vector by cross product of looking direction and up vector
+    // find up vector by cross product of right vector and looking direction
+    // normalize all the vectors
+    Vector3D look_vec(look - camera);
+    right = look_vec * up;
+    this->up = right * look_vec;
+    look_vec.normalize();
+    right.normalize();
+    this->up.normalize();
+    mid_point = camera + look_vec * near_plane;
+
+    // calculate the height and width of the near plane
+    screen_height = 2 * near_plane * tan(fov_y * M_PI / (2 * PI_DEGREE));
+    screen_width = screen_height * aspect_ratio;
+
+    // calculate the step size
+    step_x = screen_width / (number_of_pixels_y * aspect_ratio);
+    step_y = screen_height / number_of_pixels_y;
+  }
+
+  float getScreenWidth() { return screen_width; }
+  float getScreenHeight() { return screen_height; }
+
+  /**
+   * @brief the line from the camera through the center of a pixel
+   */
+  Line getLine(int x, int y) {
+    // the scale factors range from -screen_size/2 to +screen_size/2
+    float y_scale = -screen_height / 2 + step_y * y + step_y / 2;
+    float x_scale = -screen_width / 2 + step_x * x + step_x / 2;
+
+    // calculate the point on the near plane
+    Vector3D point = mid_point + right * x_scale - up * y_scale;
+
+    // generate the line from camera to the point
+    Vector3D direction = point - camera;
+    return Line(point, direction);
+  }
+
+  /**
+   * @brief the pixel together with the line through it
+   */
+  PixelLineMap getPixelLine(int x, int y) {
+    return PixelLineMap(x, y, getLine(x, y));
+  }
+};
+
+#endif  // RAY_GENERATOR_H
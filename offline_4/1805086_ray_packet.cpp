@@ -0,0 +1,67 @@
+/**
+ * @file ray_packet.cpp
+ * @brief This file contains the ray packet class
+ * a packet holds up to SIMD_WIDTH coherent rays (neighbouring primary rays)
+ * in structure of arrays layout so that one Double4 operation works on the
+ * same coordinate of every ray.
+ */
+
+#ifndef RAY_PACKET_H
+#define RAY_PACKET_H
+
+#include "1805086_line.cpp"
+#include "1805086_simd.cpp"
+#include "1805086_vector3d.cpp"
+
+using namespace std;
+
+/**
+ * @brief The RayPacket class
+ * unused lanes repeat the last ray, so every lane always holds a valid ray
+ * and the kernels never need to mask them out
+ */
+class RayPacket {
+ public:
+  Line* lines[SIMD_WIDTH];  // the rays, for the shapes without a kernel
+  int size;                 // number of lanes in use
+
+  double origin[3][SIMD_WIDTH];
+  double direction[3][SIMD_WIDTH];
+  double inverse_direction[3][SIMD_WIDTH];
+
+  /**
+   * @brief packet of the lines [0, size)
+   */
+  RayPacket(Line* lines[], int size) : size(size) {
+    for (int i = 0; i < SIMD_WIDTH; i++) {
+      Line* line = lines[i < size ? i : size - 1];
+      this->lines[i] = line;
+      Vector3D start = line->getStart();
+      Vector3D line_direction = line->getDirection();
+      for (int j = 0; j < 3; j++) {
+        origin[j][i] = start[j];
+        direction[j][i] = line_direction[j];
+        inverse_direction[j][i] = 1.0 / line_direction[j];
+      }
+    }
+  }
+
+  /**
+   * @brief a coordinate of the start of every ray
+   */
+  Double4 getOrigin(int axis) { return Double4::load(origin[axis]); }
+
+  /**
+   * @brief a coordinate of the direction of every ray
+   */
+  Double4 getDirection(int axis) { return Double4::load(direction[axis]); }
+
+  /**
+   * @brief a coordinate of 1 / direction of every ray
+   */
+  Double4 getInverseDirection(int axis) {
+    return Double4::load(inverse_direction[axis]);
+  }
+};
+
+#endif  // RAY_PACKET_H
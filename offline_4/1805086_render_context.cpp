@@ -0,0 +1,69 @@
+/**
+ * @file render_context.cpp
+ * @brief This file contains what the shading of a hit reads and writes
+ * the scene view is the part of the scene the shading reads, the renderer
+ * builds it once per frame and every render thread shares it. the render
+ * context belongs to one thread and holds the scratch memory of the shading,
+ * it is reused from pixel to pixel and from one recursion level to the next
+ * so that rendering does not allocate once it has warmed up.
+ */
+
+#ifndef RENDER_CONTEXT_H
+#define RENDER_CONTEXT_H
+
+#include <vector>
+
+#include "1805086_light.cpp"
+#include "1805086_light_sampler.cpp"
+#include "1805086_light_tree.cpp"
+#include "1805086_spot_light.cpp"
+
+using namespace std;
+
+class Accelerator;
+
+/**
+ * @brief The SceneView struct
+ * the lights, the structures over them and over the shapes, and the deepest
+ * recursion of the frame. nothing in it changes while a frame is rendered
+ */
+struct SceneView {
+  const vector<Light*>& lights;
+  const vector<SpotLight*>& spot_lights;
+  const LightTree& light_tree;
+  const LightSampler& light_sampler;
+  // answers the reflection and shadow rays
+  Accelerator& scene;
+  int recursion_level;
+};
+
+/**
+ * @brief The RenderContext class
+ * the scratch memory of the shading of one thread
+ */
+class RenderContext {
+ private:
+  const SceneView* view;
+
+ public:
+  // the lights that reach the hit that is shaded. a recursion level is done
+  // with them before it starts the next one, so the levels share the lists
+  vector<int> light_indices;
+  vector<int> spot_light_indices;
+
+  RenderContext() : view(NULL) {}
+
+  /**
+   * @brief start shading a frame of the scene, the lists are made large
+   * enough for every light so that they never grow while it is shaded
+   */
+  void setView(const SceneView& view) {
+    this->view = &view;
+    light_indices.reserve(view.lights.size());
+    spot_light_indices.reserve(view.spot_lights.size());
+  }
+
+  const SceneView& getView() const { return *view; }
+};
+
+#endif  // RENDER_CONTEXT_H
@@ -0,0 +1,260 @@
+/**
+ * @file render_statistics.cpp
+ * @brief This file contains the counters of the work done for a frame
+ * every render thread counts into its own thread_statistics, which is added
+ * to the statistics of the frame when the thread finishes a tile, so the
+ * counting itself never touches shared memory. time is measured in ticks of
+ * the time stamp counter (where there is one) and converted to milliseconds
+ * with the wall time of the whole frame.
+ */
+
+#ifndef RENDER_STATISTICS_H
+#define RENDER_STATISTICS_H
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <chrono>
+#include <ostream>
+
+using namespace std;
+
+// recursion levels that are timed separately, deeper ones share the last
+#define MAX_STATISTICS_LEVEL 8
+// one packet of primary rays out of this many is timed at the first level
+#define LEVEL_SAMPLE_INTERVAL 5
+
+/**
+ * @brief the kinds of shapes the intersection tests are counted for
+ */
+enum ShapeType {
+  SHAPE_CHECKER_BOARD,
+  SHAPE_SPHERE,
+  SHAPE_TRIANGLE,
+  SHAPE_CUBE,
+  SHAPE_PYRAMID,
+  NUMBER_OF_SHAPE_TYPES
+};
+
+const char* shape_type_names[NUMBER_OF_SHAPE_TYPES] = {
+    "checker_board", "sphere", "triangle", "cube", "pyramid"};
+
+/**
+ * @brief a cheap monotonic time stamp, in unspecified units
+ */
+inline unsigned long long read_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return chrono::duration_cast<chrono::nanoseconds>(
+             chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+/**
+ * @brief the work done for one pixel
+ */
+struct PixelCost {
+  long long intersection_tests;  // tests against shapes, of every kind
+  long long shadow_rays;         // rays towards a light source
+  int depth;                     // deepest recursion level reached
+};
+
+/**
+ * @brief The RenderStatistics class
+ */
+struct RenderStatistics {
+  long long primary_rays;          // rays from the camera
+  long long primary_hits;          // rays from the camera that hit a shape
+  long long shadow_rays;           // rays towards a light source
+  long long occlusion_early_outs;  // shadow rays stopped at the first hit
+  long long culled_lights;         // lights skipped as too far from a hit
+  long long reflection_rays;       // reflected rays
+  long long reflection_hits;       // reflected rays that hit a shape
+  // intersection tests against each kind of shape by the hierarchies, a test
+  // of a packet counts once per ray in it
+  long long intersection_tests[NUMBER_OF_SHAPE_TYPES];
+  // calls of Shape::intersect per recursion level, and the ticks spent in
+  // the timed_calls of them that were timed (including the deeper levels).
+  // the callers take the time stamps, only a sample of the first level is
+  // timed
+  long long level_calls[MAX_STATISTICS_LEVEL];
+  long long level_timed_calls[MAX_STATISTICS_LEVEL];
+  unsigned long long level_ticks[MAX_STATISTICS_LEVEL];
+  // wall time of the frame, to convert ticks to milliseconds
+  double frame_ms;
+  unsigned long long frame_ticks;
+  // deepest recursion level reached since the renderer last reset it, only
+  // meaningful for the pixel that is being shaded so it is not merged
+  int pixel_depth;
+
+  RenderStatistics()
+      : primary_rays(0),
+        primary_hits(0),
+        shadow_rays(0),
+        occlusion_early_outs(0),
+        culled_lights(0),
+        reflection_rays(0),
+        reflection_hits(0),
+        frame_ms(0),
+        frame_ticks(0),
+        pixel_depth(0) {
+    for (int i = 0; i < NUMBER_OF_SHAPE_TYPES; i++) {
+      intersection_tests[i] = 0;
+    }
+    for (int i = 0; i < MAX_STATISTICS_LEVEL; i++) {
+      level_calls[i] = 0;
+      level_timed_calls[i] = 0;
+      level_ticks[i] = 0;
+    }
+  }
+
+  /**
+   * @brief add the counts of another set of statistics
+   */
+  void add(const RenderStatistics& other) {
+    primary_rays += other.primary_rays;
+    primary_hits += other.primary_hits;
+    shadow_rays += other.shadow_rays;
+    occlusion_early_outs += other.occlusion_early_outs;
+    culled_lights += other.culled_lights;
+    reflection_rays += other.reflection_rays;
+    reflection_hits += other.reflection_hits;
+    for (int i = 0; i < NUMBER_OF_SHAPE_TYPES; i++) {
+      intersection_tests[i] += other.intersection_tests[i];
+    }
+    for (int i = 0; i < MAX_STATISTICS_LEVEL; i++) {
+      level_calls[i] += other.level_calls[i];
+      level_timed_calls[i] += other.level_timed_calls[i];
+      level_ticks[i] += other.level_ticks[i];
+    }
+  }
+
+  /**
+   * @brief count calls of Shape::intersect at a recursion level
+   */
+  void addLevel(int level, int calls) {
+    level = level < MAX_STATISTICS_LEVEL ? level : MAX_STATISTICS_LEVEL - 1;
+    level_calls[level] += calls;
+  }
+
+  /**
+   * @brief count calls of Shape::intersect at a recursion level and the time
+   * spent in them
+   * @param level the recursion level
+   * @param calls the number of calls that were timed
+   * @param ticks the ticks spent in them
+   */
+  void addLevel(int level, int calls, unsigned long long ticks) {
+    level = level < MAX_STATISTICS_LEVEL ? level : MAX_STATISTICS_LEVEL - 1;
+    level_calls[level] += calls;
+    level_timed_calls[level] += calls;
+    level_ticks[level] += ticks;
+  }
+
+  /**
+   * @brief the number of rays of every kind
+   */
+  long long getTotalRays() const {
+    return primary_rays + shadow_rays + reflection_rays;
+  }
+
+  /**
+   * @brief the work counted so far, the cost of a pixel is the difference
+   * of this before and after it is shaded
+   */
+  PixelCost getPixelCost() const {
+    PixelCost cost;
+    cost.intersection_tests = 0;
+    for (int i = 0; i < NUMBER_OF_SHAPE_TYPES; i++) {
+      cost.intersection_tests += intersection_tests[i];
+    }
+    cost.shadow_rays = shadow_rays;
+    cost.depth = pixel_depth;
+    return cost;
+  }
+
+  /**
+   * @brief ticks converted to milliseconds (summed over the threads)
+   */
+  double getMilliseconds(unsigned long long ticks) const {
+    return frame_ticks == 0 ? 0 : ticks * frame_ms / frame_ticks;
+  }
+
+  /**
+   * @brief the time spent at a recursion level, estimated from the calls
+   * that were timed
+   */
+  double getLevelMilliseconds(int level) const {
+    if (level_timed_calls[level] == 0) {
+      return 0;
+    }
+    return getMilliseconds(level_ticks[level]) * level_calls[level] /
+           level_timed_calls[level];
+  }
+
+  /**
+   * @brief print the statistics in readable form
+   */
+  void print(ostream& out) const {
+    out << "frame : " << frame_ms << " ms" << endl;
+    out << "primary rays : " << primary_rays << " (" << primary_hits
+        << " hits, " << primary_rays - primary_hits << " misses)" << endl;
+    out << "shadow rays : " << shadow_rays << " (" << occlusion_early_outs
+        << " occluded, " << culled_lights << " lights culled)" << endl;
+    out << "reflection rays : " << reflection_rays << " (" << reflection_hits
+        << " hits, " << reflection_rays - reflection_hits << " misses)"
+        << endl;
+    for (int i = 0; i < NUMBER_OF_SHAPE_TYPES; i++) {
+      out << "intersection tests " << shape_type_names[i] << " : "
+          << intersection_tests[i] << endl;
+    }
+    for (int i = 0; i < MAX_STATISTICS_LEVEL; i++) {
+      if (level_calls[i] > 0) {
+        out << "level " << i << " : " << level_calls[i] << " calls, "
+            << getLevelMilliseconds(i) << " ms" << endl;
+      }
+    }
+  }
+
+  /**
+   * @brief write the statistics as one JSON object
+   */
+  void writeJson(ostream& out) const {
+    out << "{" << endl;
+    out << "  \"frame_ms\": " << frame_ms << "," << endl;
+    out << "  \"primary_rays\": " << primary_rays << "," << endl;
+    out << "  \"primary_hits\": " << primary_hits << "," << endl;
+    out << "  \"shadow_rays\": " << shadow_rays << "," << endl;
+    out << "  \"occlusion_early_outs\": " << occlusion_early_outs << ","
+        << endl;
+    out << "  \"culled_lights\": " << culled_lights << "," << endl;
+    out << "  \"reflection_rays\": " << reflection_rays << "," << endl;
+    out << "  \"reflection_hits\": " << reflection_hits << "," << endl;
+    out << "  \"intersection_tests\": {";
+    for (int i = 0; i < NUMBER_OF_SHAPE_TYPES; i++) {
+      out << (i > 0 ? ", " : "") << "\"" << shape_type_names[i]
+          << "\": " << intersection_tests[i];
+    }
+    out << "}," << endl;
+    out << "  \"levels\": [";
+    bool first = true;
+    for (int i = 0; i < MAX_STATISTICS_LEVEL; i++) {
+      if (level_calls[i] > 0) {
+        out << (first ? "" : ", ") << "{\"level\": " << i
+            << ", \"calls\": " << level_calls[i]
+            << ", \"ms\": " << getLevelMilliseconds(i) << "}";
+        first = false;
+      }
+    }
+    out << "]" << endl;
+    out << "}" << endl;
+  }
+};
+
+// the statistics of the calling thread since its last tile was merged
+thread_local RenderStatistics thread_statistics;
+
+#endif  // RENDER_STATISTICS_H
@@ -0,0 +1,751 @@
+/**
+ * @file renderer.cpp
+ * @brief This file contains the scene and the ray traced renderer
+ * the scene is loaded from a scene file into the globals below and rendered
+ * into a frame buffer. nothing here needs a window, the GLUT viewer in
+ * main.cpp and the benchmark both drive the renderer through these functions.
+ */
+
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#define _USE_MATH_DEFINES
+#ifndef PI_DEGREE
+#define PI_DEGREE 180.0
+#endif
+
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "1805086_binary_scene.cpp"
+#include "1805086_bitmap_image.hpp"
+#include "1805086_bvh.cpp"
+#include "1805086_checker_board.cpp"
+#include "1805086_color.cpp"
+#include "1805086_cost_map.cpp"
+#include "1805086_cube.cpp"
+#include "1805086_frame_buffer.cpp"
+#include "1805086_light.cpp"
+#include "1805086_light_sampler.cpp"
+#include "1805086_light_tree.cpp"
+#include "1805086_line.cpp"
+#include "1805086_pixel_line_map.cpp"
+#include "1805086_progress_reporter.cpp"
+#include "1805086_pyramid.cpp"
+#include "1805086_ray_generator.cpp"
+#include "1805086_render_context.cpp"
+#include "1805086_render_statistics.cpp"
+#include "1805086_scene_cache.cpp"
+#include "1805086_scene_parser.cpp"
+#include "1805086_shape.cpp"
+#include "1805086_sphere.cpp"
+#include "1805086_spot_light.cpp"
+#include "1805086_tile_renderer.cpp"
+#include "1805086_triangle.cpp"
+#include "1805086_vector3d.cpp"
+
+using namespace std;
+
+/**
+ * @brief The ShapeStorage struct
+ * the shapes of the scene are created in place in a deque of each kind,
+ * which allocates them in large blocks instead of one new per shape and
+ * never moves them once they are created
+ */
+struct ShapeStorage {
+  deque<CheckerBoard> floors;
+  deque<Sphere> spheres;
+  deque<Cube> cubes;
+  deque<Pyramid> pyramids;
+
+  void clear() {
+    floors.clear();
+    spheres.clear();
+    cubes.clear();
+    pyramids.clear();
+  }
+};
+
+// global variable
+// camera
+Vector3D camera;
+// look vector
+Vector3D look;
+// up vector
+Vector3D up;
+
+// parameters
+double near_plane, far_plane, fov_y, aspect_ratio;
+// level of recursion
+int level_of_recursion;
+// number of pixels
+int number_of_pixels_y;
+// number of threads used by the renderer
+int number_of_threads = max(1u, thread::hardware_concurrency());
+// side length of a render tile in pixels
+int tile_size = 16;
+// trace the primary rays in SIMD packets
+bool use_ray_packets = true;
+// how the progress of a frame is reported, and how often
+ProgressMode progress_mode = PROGRESS_CONSOLE;
+int progress_interval_ms = 100;
+
+double width_of_cell;
+double ambient_coefficient, diffuse_coefficient, reflection_coefficient;
+
+int number_of_shapes;
+int number_of_normal_light_sources;
+int number_of_spot_light_sources;
+
+// vector of shapes, they live in shape_storage
+vector<Shape*> shapes;
+ShapeStorage shape_storage;
+vector<Light*> normal_light_sources;
+vector<SpotLight*> spot_light_sources;
+// bounding volume hierarchy over the shapes
+BVH scene_bvh;
+// the number of children of a node of scene_bvh, 2, 4 or 8
+int bvh_width = 4;
+// how the nodes of scene_bvh are split
+BVHBuild bvh_build = BVH_BUILD_SAH;
+// the 4 or 8 wide nodes of scene_bvh are compressed (see compressed_node.cpp)
+bool bvh_compressed = false;
+// the most shapes in a leaf of scene_bvh
+int bvh_leaf_size = 2;
+// the scene and scene_bvh are cached in this file (see scene_cache.cpp), empty
+// for no cache
+string scene_cache_file;
+// scene_bvh was read from the scene cache when the scene was loaded
+bool scene_bvh_cached = false;
+// the key and the binary scene of the cache that is written once scene_bvh is
+// built, the contents are empty when there is nothing to write
+SceneCacheKey scene_cache_key;
+vector<char> scene_cache_contents;
+// a light is skipped where it would add less than this to a channel, 0 shades
+// every light everywhere
+double light_threshold = 0;
+// the lights that reach a point, built with the bounding volume hierarchy
+LightTree scene_light_tree;
+// pick this many lights per hit by their estimated contribution instead of
+// shading every light, 0 shades every light
+int light_samples = 0;
+// mixed into the seed of every pixel, frames rendered with different seeds
+// pick their lights independently of each other
+uint64_t light_sample_seed = 0;
+LightSampler scene_light_sampler;
+// the scratch memory of the shading of the calling thread
+thread_local RenderContext render_context;
+// the rays traced for the last frame generated
+RenderStatistics frame_statistics;
+// record the cost of every pixel of the next frames in pixel_costs
+bool record_pixel_costs = false;
+// the cost of every pixel of the last frame, if it was recorded
+CostMap* pixel_costs = NULL;
+bitmap_image texture1;
+bitmap_image texture2;
+
+/**
+ * @brief the number of pixels along the x axis
+ */
+int get_image_width() { return (int)(number_of_pixels_y * aspect_ratio); }
+
+/**
+ * @brief what the shading reads of the loaded scene
+ * the scene view refers to the globals, it stays valid until the scene is
+ * cleared or the acceleration structure is built again
+ */
+SceneView get_scene_view() {
+  SceneView view = {normal_light_sources, spot_light_sources,
+                    scene_light_tree,     scene_light_sampler,
+                    scene_bvh,            level_of_recursion};
+  return view;
+}
+
+/**
+ * This function captures the image
+ * @param filename the name of the file to be saved
+ * @param frame_buffer the frame buffer
+ * @return false if the file could not be written
+ */
+bool capture_image(string filename, FrameBuffer* frame_buffer) {
+  // create the image
+  bitmap_image image(frame_buffer->getWidth(), frame_buffer->getHeight());
+  // clamp and quantize the pixels straight into the image
+  frame_buffer->writeTo(image);
+  // save the image
+  return image.save_image(filename.c_str());
+}
+/**
+ * This function calculates the color of a single pixel and stores it in the
+ * frame buffer
+ * @param pixel_line the pixel and the line from the camera through it
+ * @param hit the nearest hit of the line, hit.shape is NULL if nothing is hit
+ * @param frame_buffer the frame buffer
+ * @param start the work counted by the thread before the pixel was started
+ */
+void shade_pixel(PixelLineMap& pixel_line,
+                 HitRecord& hit,
+                 FrameBuffer* frame_buffer,
+                 const PixelCost& start) {
+  Line line = pixel_line.getLine();
+  thread_statistics.pixel_depth = 0;
+  // the lights sampled for a pixel only depend on the pixel and the seed
+  seed_light_samples(light_sample_seed * 0x9e3779b97f4a7c15ULL ^
+                     (((uint64_t)pixel_line.getY() << 32) | pixel_line.getX()));
+
+  // check if there is an intersection point
+  if (hit.shape != NULL) {
+    thread_statistics.primary_hits++;
+    // get the color
+    Color color(0, 0, 0);
+    // calculate the color
+    hit.shape->intersect(line, hit, render_context, color, 1);
+    // now we have the color
+    // set the color in the frame buffer, it is clamped when the frame is
+    // written out
+    frame_buffer->setPixel(pixel_line.getX(), pixel_line.getY(), color);
+  }
+
+  if (pixel_costs != NULL) {
+    PixelCost end = thread_statistics.getPixelCost();
+    PixelCost cost = {end.intersection_tests - start.intersection_tests,
+                      end.shadow_rays - start.shadow_rays, end.depth};
+    pixel_costs->setPixel(pixel_line.getX(), pixel_line.getY(), cost);
+  }
+}
+
+/**
+ * This function calculates the color of a single pixel and stores it in the
+ * frame buffer
+ * @param pixel_line the pixel and the line from the camera through it
+ * @param frame_buffer the frame buffer
+ */
+void shade_pixel(PixelLineMap& pixel_line, FrameBuffer* frame_buffer) {
+  Line line = pixel_line.getLine();
+
+  // find the nearest intersection point
+  thread_statistics.primary_rays++;
+  PixelCost start = thread_statistics.getPixelCost();
+  HitRecord hit;
+  scene_bvh.closestHit(line, INFINITY, hit);
+  unsigned long long start_ticks = read_ticks();
+  shade_pixel(pixel_line, hit, frame_buffer, start);
+  if (hit.shape != NULL) {
+    thread_statistics.addLevel(1, 1, read_ticks() - start_ticks);
+  }
+}
+
+/**
+ * This function calculates the colors of up to SIMD_WIDTH neighbouring pixels
+ * of a row, the nearest shapes of their primary rays are found with one
+ * packet query
+ * @param generator the primary ray generator
+ * @param x the first pixel
+ * @param y the row of the pixels
+ * @param count the number of pixels
+ * @param frame_buffer the frame buffer
+ */
+void shade_pixels(RayGenerator& generator,
+                  int x,
+                  int y,
+                  int count,
+                  FrameBuffer* frame_buffer) {
+  Line lines[SIMD_WIDTH];
+  Line* line_pointers[SIMD_WIDTH];
+  for (int i = 0; i < count; i++) {
+    lines[i] = generator.getLine(x + i, y);
+    line_pointers[i] = &lines[i];
+  }
+  RayPacket packet(line_pointers, count);
+  thread_statistics.primary_rays += count;
+
+  Shape* shapes_hit[SIMD_WIDTH];
+  double t[SIMD_WIDTH];
+  PixelCost packet_start = thread_statistics.getPixelCost();
+  scene_bvh.closestHit(packet, shapes_hit, t);
+  // the tests of the packet query are shared by its rays, the first rays
+  // take one more each until the remainder is used up, so the costs of the
+  // pixels add up to the tests of the frame
+  PixelCost packet_end = thread_statistics.getPixelCost();
+  long long packet_total =
+      packet_end.intersection_tests - packet_start.intersection_tests;
+  long long packet_tests = packet_total / count;
+  int packet_remainder = packet_total % count;
+  // the first recursion level is timed for one packet out of
+  // LEVEL_SAMPLE_INTERVAL, time stamps for every packet cost a few percent of
+  // the frame
+  static thread_local int packets = 0;
+  bool timed = ++packets % LEVEL_SAMPLE_INTERVAL == 0;
+  unsigned long long start_ticks = timed ? read_ticks() : 0;
+  int shaded = 0;
+  for (int i = 0; i < count; i++) {
+    // the packet query only gives the nearest shape, its hit record is
+    // filled in by a single ray query against that shape alone
+    HitRecord hit;
+    if (shapes_hit[i] != NULL &&
+        shapes_hit[i]->intersect(lines[i], 0, INFINITY, hit)) {
+      hit.shape = shapes_hit[i];
+      shaded++;
+    }
+    PixelLineMap pixel_line(x + i, y, lines[i]);
+    PixelCost start = thread_statistics.getPixelCost();
+    start.intersection_tests -= packet_tests + (i < packet_remainder ? 1 : 0);
+    shade_pixel(pixel_line, hit, frame_buffer, start);
+  }
+  if (timed) {
+    thread_statistics.addLevel(1, shaded, read_ticks() - start_ticks);
+  } else {
+    thread_statistics.addLevel(1, shaded);
+  }
+}
+
+/**
+ * This function calculates the color of the pixel and returns it in frame
+ * buffer
+ * the frame is split into tiles which are shaded by number_of_threads workers,
+ * every pixel is written by exactly one worker so the result does not depend
+ * on the number of threads
+ * @return FrameBuffer* the frame buffer, owned by the caller
+ */
+FrameBuffer* generate_image() {
+  int image_width = get_image_width();
+  // create the frame buffer
+  FrameBuffer* frame_buffer = new FrameBuffer(image_width, number_of_pixels_y);
+  delete pixel_costs;
+  pixel_costs = record_pixel_costs
+                    ? new CostMap(image_width, number_of_pixels_y)
+                    : NULL;
+
+  // the primary rays are generated when their pixel is shaded
+  RayGenerator generator(camera, look, up, near_plane, fov_y, aspect_ratio,
+                         number_of_pixels_y);
+  cout << "screen height : " << generator.getScreenHeight() << endl;
+  cout << "screen width : " << generator.getScreenWidth() << endl;
+
+  int number_of_tiles = ((image_width + tile_size - 1) / tile_size) *
+                        ((number_of_pixels_y + tile_size - 1) / tile_size);
+  mutex statistics_lock;
+  frame_statistics = RenderStatistics();
+  auto start_time = chrono::steady_clock::now();
+  unsigned long long start_ticks = read_ticks();
+  ProgressReporter progress(number_of_tiles, progress_mode, cout,
+                            progress_interval_ms);
+  SceneView view = get_scene_view();
+
+  // calculate the color of each pixel
+  render_tiles(image_width, number_of_pixels_y, tile_size, number_of_threads,
+               [&](const Tile& tile) {
+                 render_context.setView(view);
+                 for (int y = tile.y0; y < tile.y1; y++) {
+                   if (!use_ray_packets) {
+                     for (int x = tile.x0; x < tile.x1; x++) {
+                       PixelLineMap pixel_line = generator.getPixelLine(x, y);
+                       shade_pixel(pixel_line, frame_buffer);
+                     }
+                     continue;
+                   }
+                   // neighbouring pixels of a row form a packet
+                   for (int x = tile.x0; x < tile.x1; x += SIMD_WIDTH) {
+                     shade_pixels(generator, x, y,
+                                  min(SIMD_WIDTH, tile.x1 - x), frame_buffer);
+                   }
+                 }
+
+                 {
+                   lock_guard<mutex> guard(statistics_lock);
+                   // the counts of this tile go into the frame
+                   frame_statistics.add(thread_statistics);
+                   thread_statistics = RenderStatistics();
+                 }
+                 progress.advance(1);
+               });
+  progress.finish();
+  frame_statistics.frame_ticks = read_ticks() - start_ticks;
+  frame_statistics.frame_ms = chrono::duration<double, milli>(
+                                  chrono::steady_clock::now() - start_time)
+                                  .count();
+
+  // return the frame buffer
+  return frame_buffer;
+}
+
+/**
+ * This function saves the statistics of the last frame as JSON
+ * @param filename the name of the file to be saved
+ * @return false if the file could not be written
+ */
+bool save_statistics(string filename) {
+  ofstream file(filename.c_str());
+  frame_statistics.writeJson(file);
+  file.close();
+  return !file.fail();
+}
+
+/**
+ * This function saves the cost of every pixel of the last frame as an image,
+ * if it was recorded
+ * @param filename the name of the file to be saved
+ * @return false if the file could not be written
+ */
+bool save_cost_image(string filename) {
+  if (pixel_costs == NULL) {
+    return true;
+  }
+  bitmap_image image(pixel_costs->getWidth(), pixel_costs->getHeight());
+  pixel_costs->writeTo(image);
+  if (!image.save_image(filename.c_str())) {
+    return false;
+  }
+  PixelCost maximum = pixel_costs->getMaximum();
+  cout << "cost image : red " << maximum.intersection_tests
+       << " intersection tests, green " << maximum.shadow_rays
+       << " shadow rays, blue recursion level " << maximum.depth << endl;
+  return true;
+}
+
+/**
+ * @brief sets the parameters of the renderer and the checker board
+ * @param scene a SceneDescription or a BinarySceneHeader
+ */
+template <typename Parameters>
+void set_parameters(const Parameters& scene) {
+  near_plane = scene.near_plane;
+  far_plane = scene.far_plane;
+  fov_y = scene.fov_y;
+  aspect_ratio = scene.aspect_ratio;
+  level_of_recursion = scene.level_of_recursion;
+  number_of_pixels_y = scene.number_of_pixels_y;
+  width_of_cell = scene.width_of_cell;
+  ambient_coefficient = scene.ambient_coefficient;
+  diffuse_coefficient = scene.diffuse_coefficient;
+  reflection_coefficient = scene.reflection_coefficient;
+
+  CheckerBoard* floor = &shape_storage.floors.emplace_back(
+      Vector3D(0, 0, 0), Color(1, 1, 1), ambient_coefficient,
+      diffuse_coefficient, 0, reflection_coefficient, width_of_cell, false,
+      texture1, texture2);
+  floor->print();
+  // add the floor checker board to the shapes vector
+  shapes.push_back(floor);
+}
+
+/**
+ * @brief adds a sphere, cube or pyramid to the scene
+ * @param material a ShapeDescription or a BinaryMaterial
+ */
+template <typename Material>
+void add_shape(ShapeType type,
+               const double position[3],
+               double size,
+               double height,
+               const Material& material) {
+  Vector3D p(position[0], position[1], position[2]);
+  Color color(material.color[0], material.color[1], material.color[2]);
+  if (type == SHAPE_SPHERE) {
+    shapes.push_back(&shape_storage.spheres.emplace_back(
+        p, color, material.ambient, material.diffuse, material.specular,
+        material.reflection, material.shine, size));
+  } else if (type == SHAPE_PYRAMID) {
+    shapes.push_back(&shape_storage.pyramids.emplace_back(
+        p, color, material.ambient, material.diffuse, material.specular,
+        material.reflection, material.shine, size, height));
+  } else if (type == SHAPE_CUBE) {
+    shapes.push_back(&shape_storage.cubes.emplace_back(
+        p, color, material.ambient, material.diffuse, material.specular,
+        material.reflection, material.shine, size));
+  }
+}
+
+/**
+ * @brief adds a white light source to the scene
+ */
+void add_light(const double position[3], double falloff) {
+  Vector3D p(position[0], position[1], position[2]);
+  normal_light_sources.push_back(new Light(p, Color(1, 1, 1), falloff));
+}
+
+/**
+ * @brief adds a white spot light source to the scene
+ * @param pointing the point the spot light is looking at
+ * @param angle the angle of the cone in degrees
+ */
+void add_spot_light(const double position[3],
+                    double falloff,
+                    const double pointing[3],
+                    double angle) {
+  Vector3D p(position[0], position[1], position[2]);
+  Vector3D direction = Vector3D(pointing[0], pointing[1], pointing[2]) - p;
+  direction.normalize();
+  spot_light_sources.push_back(
+      new SpotLight(p, Color(1, 1, 1), falloff, direction, angle));
+}
+
+void print_scene_summary() {
+  number_of_shapes = shapes.size() - 1;
+  number_of_normal_light_sources = normal_light_sources.size();
+  number_of_spot_light_sources = spot_light_sources.size();
+  cout << "normal light sources : " << normal_light_sources.size() << endl;
+  cout << "spot light sources : " << spot_light_sources.size() << endl;
+  cout << "shapes : " << shapes.size() << endl;
+}
+
+/**
+ * @brief creates the shapes and light sources of a parsed scene and sets the
+ * parameters of the renderer
+ * @param scene the scene
+ */
+void load_scene(const SceneDescription& scene) {
+  set_parameters(scene);
+  shapes.reserve(shapes.size() + scene.shapes.size());
+  for (const ShapeDescription& shape : scene.shapes) {
+    add_shape(shape.type, shape.position, shape.size[0], shape.size[1],
+              shape);
+  }
+  for (const LightDescription& light : scene.lights) {
+    add_light(light.position, light.falloff);
+  }
+  for (const SpotLightDescription& light : scene.spot_lights) {
+    add_spot_light(light.position, light.falloff, light.pointing,
+                   light.angle);
+  }
+  print_scene_summary();
+}
+
+/**
+ * @brief creates the shapes and light sources of a binary scene and sets the
+ * parameters of the renderer, the records are read straight from the mapping
+ * @param scene the scene, it can be closed afterwards
+ */
+void load_scene(const BinaryScene& scene) {
+  const BinarySceneHeader& header = scene.getHeader();
+  set_parameters(header);
+  const BinaryMaterial* materials = scene.getMaterials();
+  shapes.reserve(shapes.size() + header.spheres.count + header.cubes.count +
+                 header.pyramids.count);
+
+  const BinarySphere* spheres = scene.getSpheres();
+  for (uint64_t i = 0; i < header.spheres.count; i++) {
+    add_shape(SHAPE_SPHERE, spheres[i].center, spheres[i].radius, 0,
+              materials[spheres[i].material]);
+  }
+  const BinaryCube* cubes = scene.getCubes();
+  for (uint64_t i = 0; i < header.cubes.count; i++) {
+    add_shape(SHAPE_CUBE, cubes[i].corner, cubes[i].side, 0,
+              materials[cubes[i].material]);
+  }
+  const BinaryPyramid* pyramids = scene.getPyramids();
+  for (uint64_t i = 0; i < header.pyramids.count; i++) {
+    add_shape(SHAPE_PYRAMID, pyramids[i].base, pyramids[i].width,
+              pyramids[i].height, materials[pyramids[i].material]);
+  }
+
+  const BinaryLight* lights = scene.getLights();
+  for (uint64_t i = 0; i < header.lights.count; i++) {
+    add_light(lights[i].position, lights[i].falloff);
+  }
+  const BinarySpotLight* spot_lights = scene.getSpotLights();
+  for (uint64_t i = 0; i < header.spot_lights.count; i++) {
+    add_spot_light(spot_lights[i].position, spot_lights[i].falloff,
+                   spot_lights[i].pointing, spot_lights[i].angle);
+  }
+  print_scene_summary();
+}
+
+/**
+ * @brief deletes the loaded shapes and light sources so that another scene
+ * can be loaded
+ */
+void clear_scene() {
+  for (int i = 0; i < normal_light_sources.size(); i++) {
+    delete normal_light_sources[i];
+  }
+  for (int i = 0; i < spot_light_sources.size(); i++) {
+    delete spot_light_sources[i];
+  }
+  shapes.clear();
+  shape_storage.clear();
+  normal_light_sources.clear();
+  spot_light_sources.clear();
+  scene_bvh = BVH();
+  scene_bvh_cached = false;
+  vector<char>().swap(scene_cache_contents);
+  scene_light_tree = LightTree();
+  scene_light_sampler = LightSampler();
+}
+
+/**
+ * @brief loads a scene through the scene cache. if the cache was built from
+ * the same scene file with the same options scene_bvh is read from it too,
+ * otherwise the cache is written once build_acceleration_structure built it.
+ * the shapes are created from the binary form of the scene either way, so
+ * that they are in the order the cached hierarchy refers to
+ * @return false if the file could not be read or is not a valid scene, the
+ * reason is printed to cerr
+ */
+bool load_cached_scene(const string& filename) {
+  MappedFile file;
+  if (!file.open(filename)) {
+    cerr << "cannot read " << filename << endl;
+    return false;
+  }
+  scene_cache_key = get_scene_cache_key(file.getData(), file.getSize(),
+                                        bvh_width, bvh_build, bvh_leaf_size,
+                                        bvh_compressed);
+  scene_cache_contents.clear();
+
+  SceneCache cache;
+  BinaryScene scene;
+  if (cache.open(scene_cache_file, scene_cache_key)) {
+    const SceneCacheHeader& header = cache.getHeader();
+    if (scene.open(cache.getScene(), header.scene.count)) {
+      load_scene(scene);
+      scene_bvh_cached = scene_bvh.load(
+          shapes, bvh_leaf_size, bvh_width, bvh_compressed, bvh_build,
+          header.sah_cost,
+          cache.getIndices(), header.indices.count, cache.getNodes(),
+          header.nodes.count);
+      if (scene_bvh_cached) {
+        cout << "scene and bvh read from " << scene_cache_file << endl;
+        return true;
+      }
+      clear_scene();
+    }
+    cout << scene_cache_file << " : corrupt, rebuilding it" << endl;
+  } else {
+    cout << scene_cache_file << " : " << cache.getError() << ", building it"
+         << endl;
+  }
+
+  if (is_binary_scene(file.getData(), file.getSize())) {
+    scene_cache_contents.assign(file.getData(),
+                                file.getData() + file.getSize());
+  } else {
+    SceneParser parser;
+    SceneDescription description;
+    parser.setSource(filename);
+    if (!parser.parse(file.getData(), file.getData() + file.getSize(),
+                      description)) {
+      cerr << parser.getError() << endl;
+      return false;
+    }
+    encode_binary_scene(description, scene_cache_contents);
+  }
+  if (!scene.open(scene_cache_contents.data(), scene_cache_contents.size())) {
+    cerr << filename << ": " << scene.getError() << endl;
+    scene_cache_contents.clear();
+    return false;
+  }
+  load_scene(scene);
+  return true;
+}
+
+/**
+ * @brief Loads the data from the file
+ * a binary scene (see binary_scene.cpp) is recognized by its first bytes,
+ * anything else is parsed as a scene.txt file. with a scene_cache_file the
+ * scene is loaded through the cache (see load_cached_scene)
+ * @param filename the name of the file
+ * @return false if the file could not be read or is not a valid scene, the
+ * reason is printed to cerr
+ */
+bool load_parameters(string filename) {
+  // load the textures
+  texture1 = bitmap_image("texture_b.bmp");
+  texture2 = bitmap_image("texture_w.bmp");
+
+  auto start = chrono::steady_clock::now();
+  if (!scene_cache_file.empty()) {
+    if (!load_cached_scene(filename)) {
+      return false;
+    }
+  } else if (BinaryScene::isBinaryScene(filename)) {
+    BinaryScene scene;
+    if (!scene.open(filename)) {
+      cerr << scene.getError() << endl;
+      return false;
+    }
+    load_scene(scene);
+  } else {
+    SceneParser parser;
+    SceneDescription scene;
+    if (!parser.parseFile(filename, scene)) {
+      cerr << parser.getError() << endl;
+      return false;
+    }
+    cout << filename << " parsed in "
+         << chrono::duration<double, milli>(chrono::steady_clock::now() -
+                                            start)
+                .count()
+         << " ms" << endl;
+    load_scene(scene);
+  }
+  auto end = chrono::steady_clock::now();
+  cout << filename << " loaded in "
+       << chrono::duration<double, milli>(end - start).count() << " ms"
+       << endl;
+  return true;
+}
+
+/**
+ * @brief builds the bounding volume hierarchy over the loaded shapes
+ * has to be called after load_parameters and before generate_image
+ */
+void build_acceleration_structure() {
+  auto start = chrono::steady_clock::now();
+  if (!scene_bvh_cached) {
+    scene_bvh = BVH(shapes, bvh_leaf_size, bvh_width, bvh_build,
+                    number_of_threads, bvh_compressed);
+  }
+  auto bvh_end = chrono::steady_clock::now();
+  cout << "bvh nodes : " << scene_bvh.getNodeCount() << " of width "
+       << scene_bvh.getWidth();
+  if (scene_bvh.isCompressed()) {
+    cout << " compressed";
+  }
+  cout << " (" << scene_bvh.getNodeBytes() / 1024.0 << " KiB)";
+  if (scene_bvh_cached) {
+    cout << " read from the cache";
+  } else {
+    cout << " built in "
+         << chrono::duration<double, milli>(bvh_end - start).count()
+         << " ms";
+  }
+  cout << ", sah cost " << scene_bvh.getSAHCost() << endl;
+
+  if (!scene_cache_contents.empty()) {
+    if (write_scene_cache(scene_cache_file, scene_cache_key,
+                          scene_cache_contents, scene_bvh)) {
+      cout << "scene cache written to " << scene_cache_file << " in "
+           << chrono::duration<double, milli>(chrono::steady_clock::now() -
+                                              bvh_end)
+                  .count()
+           << " ms" << endl;
+    } else {
+      cerr << "cannot write " << scene_cache_file << endl;
+    }
+    vector<char>().swap(scene_cache_contents);
+  }
+
+  auto lights_start = chrono::steady_clock::now();
+  scene_light_tree =
+      LightTree(normal_light_sources, spot_light_sources, light_threshold);
+  scene_light_sampler =
+      LightSampler(normal_light_sources, spot_light_sources, light_samples);
+  auto end = chrono::steady_clock::now();
+  cout << "light structures built in "
+       << chrono::duration<double, milli>(end - lights_start).count()
+       << " ms" << endl;
+  if (scene_light_tree.isCulling()) {
+    cout << "lights with a bounded influence : "
+         << scene_light_tree.getBoundedCount() << endl;
+  }
+}
+
+#endif  // RENDERER_H
@@ -0,0 +1,223 @@
+/**
+ * @file scene_cache.cpp
+ * @brief This file contains the scene cache format
+ * a scene cache holds a scene as a binary scene (see binary_scene.cpp)
+ * followed by the bounding volume hierarchy built over its shapes, so that a
+ * later run maps it and neither parses the scene nor builds the hierarchy.
+ * it is keyed by a hash of the contents of the scene file and by the options
+ * of the build, a cache that does not match them is stale and is rebuilt.
+ */
+
+#ifndef SCENE_CACHE_H
+#define SCENE_CACHE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "1805086_binary_scene.cpp"
+#include "1805086_bvh.cpp"
+#include "1805086_mapped_file.cpp"
+
+using namespace std;
+
+const char SCENE_CACHE_MAGIC[8] = {'R', 'T', 'C', 'A', 'C', 'H', 'E', '\0'};
+// changes whenever the hierarchy is built differently for the same options
+const uint32_t SCENE_CACHE_VERSION = 1;
+
+/**
+ * @brief what a scene cache is built from, it is stale if any of it differs
+ */
+struct SceneCacheKey {
+  uint64_t scene_hash;
+  uint64_t scene_size;
+  int32_t bvh_width;
+  int32_t bvh_build;
+  int32_t max_leaf_size;
+  int32_t bvh_compressed;
+};
+
+struct SceneCacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  SceneCacheKey key;
+  uint32_t node_size;
+  uint32_t padding;
+  double sah_cost;
+
+  BinarySceneArray scene;    // bytes of the binary scene
+  BinarySceneArray indices;  // primitive indices ordered by leaf, int32
+  BinarySceneArray nodes;    // nodes of the width of the key
+};
+
+static_assert(sizeof(SceneCacheKey) == 32, "scene cache key layout");
+static_assert(sizeof(SceneCacheHeader) == 112, "scene cache header layout");
+
+/**
+ * @brief the key of a scene file and of the options of the build
+ * @param data the contents of the scene file
+ */
+SceneCacheKey get_scene_cache_key(const char* data,
+                                  size_t size,
+                                  int bvh_width,
+                                  BVHBuild bvh_build,
+                                  int max_leaf_size,
+                                  bool bvh_compressed) {
+  SceneCacheKey key;
+  memset(&key, 0, sizeof(key));
+  key.scene_hash = hash_bytes(data, size);
+  key.scene_size = size;
+  key.bvh_width = bvh_width;
+  key.bvh_build = bvh_build;
+  key.max_leaf_size = max_leaf_size;
+  key.bvh_compressed = bvh_compressed;
+  return key;
+}
+
+/**
+ * @brief The SceneCache class
+ * a memory mapped scene cache, the arrays stay valid until the cache is
+ * closed or destroyed
+ */
+class SceneCache {
+ private:
+  MappedFile file;
+  string error;
+
+  /**
+   * @brief checks that an array lies inside the file
+   */
+  bool checkArray(const BinarySceneArray& array,
+                  size_t record_size,
+                  size_t alignment) {
+    size_t size = file.getSize();
+    if (array.offset % alignment != 0 || array.offset > size ||
+        array.count > (size - array.offset) / record_size) {
+      error = "truncated";
+      return false;
+    }
+    return true;
+  }
+
+ public:
+  SceneCache() {}
+
+  /**
+   * @brief why the last open failed
+   */
+  const string& getError() { return error; }
+
+  /**
+   * @brief maps a scene cache and checks that it was built for a key
+   * @return false if there is no cache, it is stale or it is not a valid
+   * cache, see getError()
+   */
+  bool open(const string& filename, const SceneCacheKey& key) {
+    close();
+    error.clear();
+    if (!file.open(filename)) {
+      error = "no cache";
+      return false;
+    }
+    const char* data = file.getData();
+    bool valid =
+        is_little_endian() && file.getSize() >= sizeof(SceneCacheHeader) &&
+        memcmp(data, SCENE_CACHE_MAGIC, sizeof(SCENE_CACHE_MAGIC)) == 0;
+    const SceneCacheHeader& header = getHeader();
+    if (!valid) {
+      error = "not a scene cache";
+    } else if (header.version != SCENE_CACHE_VERSION ||
+               header.header_size != sizeof(SceneCacheHeader) ||
+               header.node_size !=
+                   BVH::getNodeSize(key.bvh_width, key.bvh_compressed) ||
+               memcmp(&header.key, &key, sizeof(key)) != 0) {
+      error = "stale";
+      valid = false;
+    } else {
+      valid = checkArray(header.scene, 1, 8) &&
+              checkArray(header.indices, sizeof(int32_t), 8) &&
+              checkArray(header.nodes, header.node_size, 64) &&
+              header.indices.count <= INT32_MAX &&
+              header.nodes.count <= INT32_MAX;
+    }
+    if (!valid) {
+      file.close();
+    }
+    return valid;
+  }
+
+  /**
+   * @brief unmaps the cache
+   */
+  void close() { file.close(); }
+
+  const SceneCacheHeader& getHeader() const {
+    return *(const SceneCacheHeader*)file.getData();
+  }
+  const char* getScene() const {
+    return file.getData() + getHeader().scene.offset;
+  }
+  const int32_t* getIndices() const {
+    return (const int32_t*)(file.getData() + getHeader().indices.offset);
+  }
+  const char* getNodes() const {
+    return file.getData() + getHeader().nodes.offset;
+  }
+};
+
+/**
+ * @brief appends bytes to the file contents, after padding it to an
+ * alignment, and notes where they are in the header
+ */
+void append_bytes(vector<char>& contents,
+                  const char* bytes,
+                  size_t size,
+                  size_t record_size,
+                  size_t alignment,
+                  BinarySceneArray& array) {
+  contents.resize((contents.size() + alignment - 1) / alignment * alignment);
+  array.offset = contents.size();
+  array.count = size / record_size;
+  contents.insert(contents.end(), bytes, bytes + size);
+}
+
+/**
+ * @brief writes a scene cache
+ * @param key what the hierarchy was built from
+ * @param scene the binary scene the shapes of the hierarchy were created from
+ * @param bvh the hierarchy over the shapes of the scene
+ * @return false if the file cannot be written
+ */
+bool write_scene_cache(const string& filename,
+                       const SceneCacheKey& key,
+                       const vector<char>& scene,
+                       BVH& bvh) {
+  if (!is_little_endian()) {
+    return false;
+  }
+  SceneCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SCENE_CACHE_MAGIC, sizeof(header.magic));
+  header.version = SCENE_CACHE_VERSION;
+  header.header_size = sizeof(SceneCacheHeader);
+  header.key = key;
+  header.node_size = BVH::getNodeSize(bvh.getWidth(), bvh.isCompressed());
+  header.sah_cost = bvh.getSAHCost();
+
+  // the nodes are aligned to cache lines as they are in memory
+  vector<char> contents(sizeof(SceneCacheHeader));
+  const vector<int>& indices = bvh.getIndices();
+  append_bytes(contents, scene.data(), scene.size(), 1, 8, header.scene);
+  append_bytes(contents, (const char*)indices.data(),
+               indices.size() * sizeof(int32_t), sizeof(int32_t), 8,
+               header.indices);
+  append_bytes(contents, bvh.getNodeData(),
+               bvh.getNodeCount() * header.node_size, header.node_size, 64,
+               header.nodes);
+  memcpy(contents.data(), &header, sizeof(header));
+  return write_whole_file(filename, contents);
+}
+
+#endif  // SCENE_CACHE_H
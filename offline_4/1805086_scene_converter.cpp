@@ -0,0 +1,39 @@
+/**
+ * @file scene_converter.cpp
+ * @brief This file contains the converter from scene.txt files to binary
+ * scenes (see binary_scene.cpp), the renderer loads either.
+ *
+ * g++ -O2 1805086_scene_converter.cpp -o scene_converter
+ * ./scene_converter <scene file> <binary scene file>
+ */
+
+#include <iostream>
+#include <string>
+
+#include "1805086_binary_scene.cpp"
+#include "1805086_scene_parser.cpp"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    cerr << "usage: " << argv[0] << " <scene file> <binary scene file>"
+         << endl;
+    return 1;
+  }
+
+  SceneParser parser;
+  SceneDescription scene;
+  if (!parser.parseFile(argv[1], scene)) {
+    cerr << parser.getError() << endl;
+    return 2;
+  }
+  if (!write_binary_scene(scene, argv[2])) {
+    cerr << "cannot write " << argv[2] << endl;
+    return 3;
+  }
+  cout << argv[1] << " : " << scene.shapes.size() << " shapes, "
+       << scene.lights.size() << " lights, " << scene.spot_lights.size()
+       << " spot lights written to " << argv[2] << endl;
+  return 0;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file scene_generator.cpp
+ * @brief This file contains a generator of random scenes in the scene.txt
+ * format
+ * the same seed and counts always give the same file, the random numbers come
+ * straight from mt19937 (whose sequence is fixed by the standard) and not from
+ * the library distributions.
+ */
+
+#ifndef SCENE_GENERATOR_H
+#define SCENE_GENERATOR_H
+
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+#include <random>
+
+using namespace std;
+
+/**
+ * @brief The SceneGenerator class
+ * the shapes are scattered over the square [-100, 100] x [-100, 100] of the
+ * checker board and get smaller as there are more of them, the lights are
+ * placed above that square
+ */
+class SceneGenerator {
+ private:
+  unsigned int seed;
+  int number_of_spheres;
+  int number_of_cubes;
+  int number_of_pyramids;
+  int number_of_lights;
+  int number_of_spot_lights;
+  mt19937 random;
+
+  /**
+   * @brief a random number in [low, high)
+   */
+  double uniform(double low, double high) {
+    return low + (high - low) * (random() / 4294967296.0);
+  }
+
+  /**
+   * @brief writes a random point of the box [low, high) on one line
+   * the coordinates are drawn one after the other, so the order does not
+   * depend on how the compiler evaluates the operands of <<
+   */
+  void writePoint(ostream& out, const double low[3], const double high[3]) {
+    double x = uniform(low[0], high[0]);
+    double y = uniform(low[1], high[1]);
+    double z = uniform(low[2], high[2]);
+    out << x << " " << y << " " << z;
+  }
+
+  /**
+   * @brief writes a random color and the material of a shape
+   */
+  void writeMaterial(ostream& out) {
+    double color_low[3] = {0.2, 0.2, 0.2};
+    double color_high[3] = {1, 1, 1};
+    writePoint(out, color_low, color_high);
+    out << endl;
+    double ambient = uniform(0.05, 0.3);
+    double diffuse = uniform(0.1, 0.5);
+    double specular = uniform(0.1, 0.4);
+    double reflection = uniform(0.1, 0.5);
+    out << ambient << " " << diffuse << " " << specular << " " << reflection
+        << endl;
+    out << (int)uniform(1, 31) << endl;
+  }
+
+ public:
+  /**
+   * @brief a generator of scenes with the given number of shapes and lights
+   */
+  SceneGenerator(unsigned int seed,
+                 int number_of_spheres,
+                 int number_of_cubes,
+                 int number_of_pyramids,
+                 int number_of_lights,
+                 int number_of_spot_lights)
+      : seed(seed),
+        number_of_spheres(number_of_spheres),
+        number_of_cubes(number_of_cubes),
+        number_of_pyramids(number_of_pyramids),
+        number_of_lights(number_of_lights),
+        number_of_spot_lights(number_of_spot_lights) {}
+
+  int getNumberOfShapes() {
+    return number_of_spheres + number_of_cubes + number_of_pyramids;
+  }
+  int getNumberOfLights() { return number_of_lights + number_of_spot_lights; }
+
+  /**
+   * @brief writes the scene
+   * @param out the stream the scene file is written to
+   * @param number_of_pixels_y the number of pixels along the y axis
+   * @param level_of_recursion the level of recursion
+   */
+  void write(ostream& out, int number_of_pixels_y, int level_of_recursion) {
+    random.seed(seed);
+    out << fixed << setprecision(6);
+
+    // near plane, far plane, fov_y, aspect ratio
+    out << "1 1000 80 1.77777777777778" << endl;
+    out << level_of_recursion << endl;
+    out << number_of_pixels_y << endl;
+    out << endl;
+
+    // checker board
+    out << 10 << endl;
+    out << "0.1 0.3 0.6" << endl;
+    out << endl;
+
+    // the side of the square every shape gets on average
+    int number_of_shapes = getNumberOfShapes();
+    double spacing = 200 / sqrt((double)max(1, number_of_shapes));
+    double size = min(40.0, spacing / 2);
+
+    out << number_of_shapes << endl;
+    out << endl;
+    for (int i = 0; i < number_of_shapes; i++) {
+      double x = uniform(-100, 100);
+      double y = uniform(-100, 100);
+      if (i < number_of_spheres) {
+        double radius = uniform(size / 4, size / 2);
+        double z = radius + uniform(0, size);
+        out << "sphere" << endl;
+        out << x << " " << y << " " << z << endl;
+        out << radius << endl;
+      } else if (i < number_of_spheres + number_of_cubes) {
+        double z = uniform(0, size);
+        out << "cube" << endl;
+        out << x << " " << y << " " << z << endl;
+        out << uniform(size / 2, size) << endl;
+      } else {
+        double width = uniform(size / 2, size);
+        double height = uniform(size / 2, size);
+        out << "pyramid" << endl;
+        out << x << " " << y << " " << 0.0 << endl;
+        out << width << " " << height << endl;
+      }
+      writeMaterial(out);
+      out << endl;
+    }
+
+    // normal light sources
+    double light_low[3] = {-100, -100, 50};
+    double light_high[3] = {100, 100, 150};
+    out << number_of_lights << endl;
+    for (int i = 0; i < number_of_lights; i++) {
+      writePoint(out, light_low, light_high);
+      out << endl;
+      out << "0.000002" << endl;
+      out << endl;
+    }
+
+    // spot light sources, pointing at a point of the checker board
+    out << number_of_spot_lights << endl;
+    double target_low[3] = {-50, -50, 0};
+    double target_high[3] = {50, 50, 0};
+    for (int i = 0; i < number_of_spot_lights; i++) {
+      writePoint(out, light_low, light_high);
+      out << endl;
+      out << "0.0000002" << endl;
+      writePoint(out, target_low, target_high);
+      out << " " << uniform(20, 40) << endl;
+      out << endl;
+    }
+  }
+};
+
+#endif  // SCENE_GENERATOR_H
@@ -0,0 +1,340 @@
+/**
+ * @file scene_parser.cpp
+ * @brief This file contains the parser of the scene.txt format
+ * the whole file is read into one buffer and tokenized in a single pass, the
+ * numbers are converted with from_chars. the result is a flat description of
+ * the scene, the renderer creates its shapes and lights from it.
+ */
+
+#ifndef SCENE_PARSER_H
+#define SCENE_PARSER_H
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "1805086_render_statistics.cpp"
+
+using namespace std;
+
+/**
+ * @brief a sphere, cube or pyramid of the scene file
+ * size holds the radius of a sphere, the side of a cube or the width and
+ * height of a pyramid
+ */
+struct ShapeDescription {
+  ShapeType type;
+  double position[3];
+  double size[2];
+  float color[3];
+  double ambient, diffuse, specular, reflection;
+  int shine;
+};
+
+/**
+ * @brief a normal light source of the scene file
+ */
+struct LightDescription {
+  double position[3];
+  double falloff;
+};
+
+/**
+ * @brief a spot light source of the scene file, it points from position to
+ * pointing and lights a cone of angle degrees
+ */
+struct SpotLightDescription {
+  double position[3];
+  double falloff;
+  double pointing[3];
+  double angle;
+};
+
+/**
+ * @brief everything the scene file describes
+ */
+struct SceneDescription {
+  double near_plane, far_plane, fov_y, aspect_ratio;
+  int level_of_recursion;
+  int number_of_pixels_y;
+  // the checker board
+  double width_of_cell;
+  double ambient_coefficient, diffuse_coefficient, reflection_coefficient;
+
+  vector<ShapeDescription> shapes;
+  vector<LightDescription> lights;
+  vector<SpotLightDescription> spot_lights;
+};
+
+/**
+ * @brief The SceneParser class
+ * the format is whitespace separated, the line breaks of scene.txt are only
+ * used to report where an error is
+ */
+class SceneParser {
+ private:
+  const char* cursor;
+  const char* end;
+  int line;
+  // the name of the scene in error messages
+  string source;
+  string error;
+
+  /**
+   * @brief skips whitespace, counting the lines passed
+   */
+  void skipWhitespace() {
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t' ||
+                            *cursor == '\r' || *cursor == '\n')) {
+      if (*cursor == '\n') {
+        line++;
+      }
+      cursor++;
+    }
+  }
+
+  /**
+   * @brief remembers the first error with the line it was found on
+   * @return false, so that a failed read can return fail(...)
+   */
+  bool fail(const string& message) {
+    if (error.empty()) {
+      error = source + ":" + to_string(line) + ": " + message;
+    }
+    return false;
+  }
+
+  bool readDouble(double& value, const char* what) {
+    skipWhitespace();
+    if (cursor == end) {
+      return fail(string("expected ") + what + ", found the end of the file");
+    }
+    // from_chars takes no plus sign, which the stream extraction the parser
+    // replaced accepted. "+-1" stays an error
+    const char* number = cursor;
+    if (*number == '+' && number + 1 != end && number[1] != '-') {
+      number++;
+    }
+    from_chars_result result = from_chars(number, end, value);
+    if (result.ec != errc() || !isSeparator(result.ptr)) {
+      return fail(string("expected ") + what + ", found \"" + token() + "\"");
+    }
+    cursor = result.ptr;
+    return true;
+  }
+
+  bool readFloat(float& value, const char* what) {
+    double parsed;
+    if (!readDouble(parsed, what)) {
+      return false;
+    }
+    value = (float)parsed;
+    return true;
+  }
+
+  /**
+   * @brief reads an integer, a whole number written as 30.0 is accepted too
+   */
+  bool readInt(int& value, const char* what) {
+    double parsed;
+    if (!readDouble(parsed, what)) {
+      return false;
+    }
+    if (parsed != floor(parsed) || fabs(parsed) > 2147483647.0) {
+      return fail(string("expected ") + what + ", found " + to_string(parsed));
+    }
+    value = (int)parsed;
+    return true;
+  }
+
+  /**
+   * @brief reads a non negative count of objects
+   */
+  bool readCount(int& value, const char* what) {
+    if (!readInt(value, what)) {
+      return false;
+    }
+    return value >= 0 || fail(string(what) + " is negative");
+  }
+
+  bool readPoint(double point[3], const char* what) {
+    return readDouble(point[0], what) && readDouble(point[1], what) &&
+           readDouble(point[2], what);
+  }
+
+  /**
+   * @brief whether a token ends at p
+   */
+  bool isSeparator(const char* p) {
+    return p == end || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n';
+  }
+
+  /**
+   * @brief the token at the cursor, for error messages
+   */
+  string token() {
+    const char* p = cursor;
+    while (!isSeparator(p)) {
+      p++;
+    }
+    return string(cursor, p);
+  }
+
+  bool readShape(ShapeDescription& shape) {
+    skipWhitespace();
+    string type = token();
+    cursor += type.size();
+    shape.size[1] = 0;
+    if (type == "sphere") {
+      shape.type = SHAPE_SPHERE;
+      if (!readPoint(shape.position, "the center of a sphere") ||
+          !readDouble(shape.size[0], "the radius of a sphere")) {
+        return false;
+      }
+    } else if (type == "cube") {
+      shape.type = SHAPE_CUBE;
+      if (!readPoint(shape.position, "the corner of a cube") ||
+          !readDouble(shape.size[0], "the side of a cube")) {
+        return false;
+      }
+    } else if (type == "pyramid") {
+      shape.type = SHAPE_PYRAMID;
+      if (!readPoint(shape.position, "the base of a pyramid") ||
+          !readDouble(shape.size[0], "the width of a pyramid") ||
+          !readDouble(shape.size[1], "the height of a pyramid")) {
+        return false;
+      }
+    } else if (type.empty()) {
+      return fail("expected a shape, found the end of the file");
+    } else {
+      return fail("unknown shape \"" + type + "\"");
+    }
+    return readFloat(shape.color[0], "a color") &&
+           readFloat(shape.color[1], "a color") &&
+           readFloat(shape.color[2], "a color") &&
+           readDouble(shape.ambient, "the ambient coefficient") &&
+           readDouble(shape.diffuse, "the diffuse coefficient") &&
+           readDouble(shape.specular, "the specular coefficient") &&
+           readDouble(shape.reflection, "the reflection coefficient") &&
+           readInt(shape.shine, "the specular exponent");
+  }
+
+ public:
+  SceneParser() : cursor(NULL), end(NULL), line(1), source("scene") {}
+
+  /**
+   * @brief the first error of the last parse, with its line number
+   */
+  const string& getError() { return error; }
+
+  /**
+   * @brief the name the errors of parse() give the scene, "scene" by default
+   */
+  void setSource(const string& source) { this->source = source; }
+
+  /**
+   * @brief parses a scene held in memory
+   * @param begin the first character of the scene
+   * @param end one past the last character of the scene
+   * @param scene filled with the scene
+   * @return false if the scene is not valid, see getError()
+   */
+  bool parse(const char* begin, const char* end, SceneDescription& scene) {
+    cursor = begin;
+    this->end = end;
+    line = 1;
+    error.clear();
+    scene.shapes.clear();
+    scene.lights.clear();
+    scene.spot_lights.clear();
+
+    int number_of_shapes, number_of_lights, number_of_spot_lights;
+    if (!readDouble(scene.near_plane, "the near plane") ||
+        !readDouble(scene.far_plane, "the far plane") ||
+        !readDouble(scene.fov_y, "the field of view") ||
+        !readDouble(scene.aspect_ratio, "the aspect ratio") ||
+        !readInt(scene.level_of_recursion, "the level of recursion") ||
+        !readInt(scene.number_of_pixels_y, "the number of pixels") ||
+        !readDouble(scene.width_of_cell, "the width of a cell") ||
+        !readDouble(scene.ambient_coefficient, "the ambient coefficient") ||
+        !readDouble(scene.diffuse_coefficient, "the diffuse coefficient") ||
+        !readDouble(scene.reflection_coefficient,
+                    "the reflection coefficient") ||
+        !readCount(number_of_shapes, "the number of shapes")) {
+      return false;
+    }
+
+    // a shape takes at least 26 characters, a wrong count does not make the
+    // parser allocate more than the file can hold
+    scene.shapes.reserve(min<size_t>(number_of_shapes, (end - cursor) / 26));
+    for (int i = 0; i < number_of_shapes; i++) {
+      ShapeDescription shape;
+      if (!readShape(shape)) {
+        return false;
+      }
+      scene.shapes.push_back(shape);
+    }
+
+    if (!readCount(number_of_lights, "the number of light sources")) {
+      return false;
+    }
+    for (int i = 0; i < number_of_lights; i++) {
+      LightDescription light;
+      if (!readPoint(light.position, "the position of a light source") ||
+          !readDouble(light.falloff, "the falloff of a light source")) {
+        return false;
+      }
+      scene.lights.push_back(light);
+    }
+
+    if (!readCount(number_of_spot_lights, "the number of spot lights")) {
+      return false;
+    }
+    for (int i = 0; i < number_of_spot_lights; i++) {
+      SpotLightDescription light;
+      if (!readPoint(light.position, "the position of a spot light") ||
+          !readDouble(light.falloff, "the falloff of a spot light") ||
+          !readPoint(light.pointing, "the point a spot light looks at") ||
+          !readDouble(light.angle, "the angle of a spot light")) {
+        return false;
+      }
+      scene.spot_lights.push_back(light);
+    }
+
+    skipWhitespace();
+    if (cursor != end) {
+      return fail("unexpected \"" + token() + "\" after the last spot light");
+    }
+    return true;
+  }
+
+  /**
+   * @brief reads a scene file into memory and parses it
+   * @return false if the file cannot be read or is not valid, see getError()
+   */
+  bool parseFile(const string& filename, SceneDescription& scene) {
+    error.clear();
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (file == NULL) {
+      error = "cannot read " + filename;
+      return false;
+    }
+    source = filename;
+    vector<char> buffer;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size > 0) {
+      buffer.resize(size);
+      size = fread(buffer.data(), 1, size, file);
+    }
+    fclose(file);
+    bool parsed = parse(buffer.data(), buffer.data() + max(0L, size), scene);
+    source = "scene";
+    return parsed;
+  }
+};
+
+#endif  // SCENE_PARSER_H
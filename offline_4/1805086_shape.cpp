@@ -8,12 +8,46 @@
 #include <cmath>
 #include <vector>
 
+#include "1805086_aabb.cpp"
 #include "1805086_color.cpp"
+#include "1805086_fast_math.cpp"
+#include "1805086_hit_record.cpp"
 #include "1805086_light.cpp"
+#include "1805086_light_sampler.cpp"
+#include "1805086_light_tree.cpp"
 #include "1805086_line.cpp"
+#include "1805086_ray_packet.cpp"
+#include "1805086_render_context.cpp"
+#include "1805086_render_statistics.cpp"
 #include "1805086_spot_light.cpp"
 #include "1805086_vector3d.cpp"
 
+class Shape;
+
+/**
+ * @brief interface of the structures that answer ray queries against the
+ * whole scene (see 1805086_bvh.cpp)
+ */
+class Accelerator {
+ public:
+  /**
+   * @brief find the nearest shape hit by the line
+   * @param line the ray
+   * @param t_max only hits with 0 < t < t_max count
+   * @param hit filled with the nearest hit
+   * @return the nearest shape or NULL if nothing is hit
+   */
+  virtual Shape* closestHit(Line& line, double t_max, HitRecord& hit) = 0;
+
+  /**
+   * @brief check if any shape is hit with 0 < t < t_max, stops at the first
+   * hit that is found
+   */
+  virtual bool occluded(Line& line, double t_max) = 0;
+
+  virtual ~Accelerator() {}
+};
+
 class Shape {
  protected:
   Vector3D position;              // center of the shape
@@ -47,6 +81,8 @@ class Shape {
         reflection_coefficient(reflection_coefficient),
         specular_exponent(specular_exponent) {}
 
+  virtual ~Shape() {}
+
   Vector3D getPosition() { return position; }
   Color getColor() { return color; }
   double getAmbientCoefficient() { return ambient_coefficient; }
@@ -68,183 +104,234 @@ class Shape {
   void setReflectionCoefficient(double reflection_coefficient) {
     this->reflection_coefficient = reflection_coefficient;
   }
+ protected:
+  /**
+   * @brief the diffuse and specular light of one light source at a hit
+   * @param line the incident line
+   * @param hit the hit of the line on this shape
+   * @param color_at_intersection_point the color of the shape at the hit
+   * @param light the light source
+   * @param spot_light the same light if it is a spot light, otherwise NULL
+   * @param scaling_factor the attenuation exp(-distance^2 * falloff) of the
+   * light at the hit
+   * @param scene answers the shadow ray
+   * @param light_color set to the light of this source alone
+   * @return false if the light does not reach the hit, because it is outside
+   * the cone of the spot light or something is in the way
+   */
+  bool addLight(Line& line,
+                HitRecord& hit,
+                Color& color_at_intersection_point,
+                Light* light,
+                SpotLight* spot_light,
+                double scaling_factor,
+                Accelerator& scene,
+                Color& light_color) {
+    // get the light position and direction
+    Vector3D light_position = light->getPosition();
+    Vector3D light_direction = light_position - hit.point;
+    double distance = light_direction.length();
+
+    // generate a new line from the light source to the intersection point
+    Line light_line(light_position, light_direction * (-1));
+
+    // get the normal at the intersection point
+    Vector3D normal = hit.getNormal(light_line.getDirection());
+
+    // another extra check for spot light
+    // check if the light source is within the cone of the spot light
+    // (the angle between the light direction and the spot light direction is
+    // < spot light angle)
+    if (spot_light != NULL &&
+        !spot_light->isInCone(light_direction * (-1), distance)) {
+      return false;
+    }
+
+    // check if the light source is visible from the intersection point
+    // the light line starts at the light, anything closer to the light
+    // than the intersection point casts a shadow
+    thread_statistics.shadow_rays++;
+    if (scene.occluded(light_line, distance - 0.0001)) {
+      return false;
+    }
+
+    // lambertian shading
+    double lambart_component =
+        (normal * (-1)).dot_product(light_line.getDirection());
+    lambart_component *= scaling_factor;
+    if (lambart_component < 0) {
+      lambart_component = 0;
+    }
+
+    // phong shading
+    // ar first, we need to get the reflection vector
+    double dot_product = normal.dot_product(light_line.getDirection());
+    Vector3D reflection_vector =
+        light_line.getDirection() - normal * 2 * dot_product;
+
+    double phong_component =
+        (line.getDirection() * (-1)).dot_product(reflection_vector);
+    if (phong_component < 0) {
+      phong_component = 0;
+    }
+
+    // diffuse and specular light
+    light_color = color_at_intersection_point * lambart_component *
+                  diffuse_coefficient * light->getColor();
+
+    light_color =
+        light_color + color_at_intersection_point *
+                          int_pow(phong_component, specular_exponent) *
+                          scaling_factor * specular_coefficient *
+                          light->getColor();
+    return true;
+  }
+
+  static SpotLight* asSpotLight(Light*) { return NULL; }
+  static SpotLight* asSpotLight(SpotLight* light) { return light; }
+
+  /**
+   * @brief add the light of every light source that reaches the hit to the
+   * color to return, each exactly once, so a light that is culled only
+   * drops its own term. the attenuations are computed SIMD_WIDTH lights at
+   * a time, with fast_exp where AVX2 makes that faster than libm exp
+   * @param indices the lights to add, every light if NULL
+   */
+  template <typename LightType>
+  void addLights(Line& line,
+                 HitRecord& hit,
+                 Color& color_at_intersection_point,
+                 const vector<LightType*>& lights,
+                 const vector<int>* indices,
+                 Accelerator& scene,
+                 Color& color_to_return) {
+    int number_of_lights = indices != NULL ? indices->size() : lights.size();
+    for (int first = 0; first < number_of_lights; first += SIMD_WIDTH) {
+      int count = min(SIMD_WIDTH, number_of_lights - first);
+      LightType* batch[SIMD_WIDTH];
+      double exponents[SIMD_WIDTH] = {0, 0, 0, 0};
+      for (int k = 0; k < count; k++) {
+        int i = indices != NULL ? (*indices)[first + k] : first + k;
+        batch[k] = lights[i];
+        Vector3D light_direction = batch[k]->getPosition() - hit.point;
+        exponents[k] = -1 * light_direction.length() *
+                       light_direction.length() * batch[k]->getFalloff();
+      }
+      double attenuations[SIMD_WIDTH];
+#if defined(__AVX2__)
+      fast_exp(Double4::load(exponents)).store(attenuations);
+#else
+      // in two SSE2 halves fast_exp is no faster than libm
+      for (int k = 0; k < count; k++) {
+        attenuations[k] = exp(exponents[k]);
+      }
+#endif
+
+      for (int k = 0; k < count; k++) {
+        Color light_color(0, 0, 0);
+        if (addLight(line, hit, color_at_intersection_point, batch[k],
+                     asSpotLight(batch[k]), attenuations[k], scene,
+                     light_color)) {
+          color_to_return = color_to_return + light_color;
+        }
+      }
+    }
+  }
+
+ public:
+  /**
+   * @brief shade a hit on this shape
+   * @param line the incident line
+   * @param hit the hit of the line on this shape
+   * @param context the scene that is shaded and the scratch memory of the
+   * calling thread
+   * @param color_to_return the color of the hit is added to it
+   * @param current_level the recursion level of the hit, starting at 1
+   * @return the distance of the hit
+   */
   double intersect(Line& line,
-                   vector<Light*> lights,
-                   vector<SpotLight*> spot_lights,
-                   vector<Shape*> shapes,
+                   HitRecord& hit,
+                   RenderContext& context,
                    Color& color_to_return,
-                   int current_level,
-                   int recursion_level) {
-    double t = getT(line);
-    if (t < 0) {
-      return -1;  // no intersection
-    }
+                   int current_level) {
+    const SceneView& view = context.getView();
+    const vector<Light*>& lights = view.lights;
+    const vector<SpotLight*>& spot_lights = view.spot_lights;
+    const LightSampler& light_sampler = view.light_sampler;
+    Accelerator& scene = view.scene;
+
+    double t = hit.t;
     if (current_level == 0) {
       return t;
     }
+    if (current_level > thread_statistics.pixel_depth) {
+      thread_statistics.pixel_depth = current_level;
+    }
     // get the intersection point
-    Vector3D intersection_point = line.getPoint(t);
+    const Vector3D& intersection_point = hit.point;
     // get the color at the intersection point
-    Color color_at_intersection_point = getColorAt(intersection_point);
+    Color color_at_intersection_point = getColorAt(hit);
     // update the color value with ambient light
     Color color_value = color_at_intersection_point * ambient_coefficient;
 
     color_to_return = color_to_return + color_value;
 
-    // for each light source
-    for (int i = 0; i < lights.size(); i++) {
-      // get the light position and direction
-      Vector3D light_position = lights[i]->getPosition();
-      Vector3D light_direction = light_position - intersection_point;  //
-
-      // generate a new line from the light source to the intersection point
-      Line light_line(light_position, light_direction);
-
-      // get the normal at the intersection point
-      Line normal_line = this->getNormal(intersection_point, light_line);
-      // find the scaling factor for the intersection point
-      // exp(-distance*distance*S.falloff);
-      double scaling_factor =
-          exp(-1 * light_direction.length() * light_direction.length() *
-              lights[i]->getFalloff());
-
-      // check if the light source is visible from the intersection point
-      bool is_visible = true;
-      for (int j = 0; j < shapes.size(); j++) {
-        double other_t = shapes[j]->getT(light_line);
-        if (other_t > 0 && other_t < t - 0.0001) {
-          is_visible = false;
-          break;
-        }
-      }
-
-      // if the light source is visible from the intersection point
-      if (is_visible) {
-        // lambertian shading
-        double lambart_component = (normal_line.getDirection() * (-1))
-                                       .dot_product(light_line.getDirection());
-        lambart_component *= scaling_factor;
-        if (lambart_component < 0) {
-          lambart_component = 0;
-        }
-
-        // phong shading
-        // ar first, we need to get the reflection vector
-        double dot_product =
-            normal_line.getDirection().dot_product(light_line.getDirection());
-        Vector3D reflection_vector =
-            light_line.getDirection() -
-            normal_line.getDirection() * 2 * dot_product;
-
-        double phong_component =
-            (line.getDirection() * (-1)).dot_product(reflection_vector);
-        if (phong_component < 0) {
-          phong_component = 0;
-        }
-
-        // update the color value with diffuse and specular light
-        color_value =
-            color_value + color_at_intersection_point * lambart_component *
-                              diffuse_coefficient * lights[i]->getColor();
-
-        color_value =
-            color_value + color_at_intersection_point *
-                              pow(phong_component, specular_exponent) *
-                              scaling_factor * specular_coefficient *
-                              lights[i]->getColor();
-
-        // update the color to return
-        color_to_return = color_to_return + color_value;
-      }
+    // the lights that reach the intersection point, every light if none are
+    // culled
+    vector<int>& light_indices = context.light_indices;
+    vector<int>& spot_light_indices = context.spot_light_indices;
+    bool culling = view.light_tree.isCulling() && !light_sampler.isSampling();
+    if (culling) {
+      view.light_tree.query(intersection_point, light_indices,
+                            spot_light_indices);
+      thread_statistics.culled_lights +=
+          lights.size() + spot_lights.size() - light_indices.size() -
+          spot_light_indices.size();
     }
 
-    // same for spot light
-    for (int i = 0; i < spot_lights.size(); i++) {
-      // get the light position and direction
-      Vector3D light_position = spot_lights[i]->getPosition();
-      Vector3D light_direction = light_position - intersection_point;
-
-      // generate a new line from the light source to the intersection point
-      Line light_line(light_position, light_direction);
-
-      // get the normal at the intersection point
-      Line normal_line = getNormal(intersection_point, light_line);
-      // find the scaling factor for the intersection point
-      // exp(-distance*distance*S.falloff);
-      double scaling_factor =
-          exp(-1 * light_direction.length() * light_direction.length() *
-              spot_lights[i]->getFalloff());
-
-      // check if the light source is visible from the intersection point
-      bool is_visible = true;
-      for (int j = 0; j < shapes.size(); j++) {
-        double other_t = shapes[j]->getT(light_line);
-        if (other_t > 0 && other_t < t - 0.0001) {
-          is_visible = false;
+    if (light_sampler.isSampling()) {
+      // a fixed number of lights picked by their estimated contribution, the
+      // sum over them is weighted so that it estimates the sum over all
+      int samples = light_sampler.getSamplesPerHit();
+      Color sampled(0, 0, 0);
+      for (int k = 0; k < samples; k++) {
+        LightSample sample;
+        if (!light_sampler.sample(intersection_point, sample)) {
           break;
         }
-      }
-
-      // another extra check for spot light
-      // check if the light source is within the cone of the spot light
-      // (the angle between the light direction and the spot light direction is
-      // < spot light angle)
-      double angle =
-          spot_lights[i]->getDirection().angle(light_direction * (-1));
-      // angle is in radian
-      if (angle * 180 / M_PI > spot_lights[i]->getAngle()) {
-        is_visible = false;
-      }
-
-      // if the light source is visible from the intersection point
-      if (is_visible) {
-        // lambertian shading
-        double lambart_component = (normal_line.getDirection() * (-1))
-                                       .dot_product(light_line.getDirection());
-        lambart_component *= scaling_factor;
-        if (lambart_component < 0) {
-          lambart_component = 0;
-        }
-
-        // phong shading
-        // ar first, we need to get the reflection vector
-        double dot_product =
-            normal_line.getDirection().dot_product(light_line.getDirection());
-        Vector3D reflection_vector =
-            light_line.getDirection() -
-            (normal_line.getDirection() * 2) * dot_product;
-
-        double phong_component =
-            (line.getDirection() * (-1)).dot_product(reflection_vector);
-        if (phong_component < 0) {
-          phong_component = 0;
+        Light* light = sample.spot ? spot_lights[sample.index]
+                                   : lights[sample.index];
+        Vector3D light_direction = light->getPosition() - intersection_point;
+        // one light at a time libm is faster than the scalar fast_exp
+        double scaling_factor =
+            exp(-1 * light_direction.length() * light_direction.length() *
+                light->getFalloff());
+        Color contribution(0, 0, 0);
+        if (addLight(line, hit, color_at_intersection_point, light,
+                     sample.spot ? spot_lights[sample.index] : NULL,
+                     scaling_factor, scene, contribution)) {
+          sampled = sampled + contribution * (1 / (sample.probability *
+                                                   samples));
         }
-
-        // update the color value with diffuse and specular light
-        color_value =
-            color_value + color_at_intersection_point * lambart_component *
-                              diffuse_coefficient * spot_lights[i]->getColor();
-
-        color_value =
-            color_value + color_at_intersection_point *
-                              pow(phong_component, specular_exponent) *
-                              scaling_factor * specular_coefficient *
-                              spot_lights[i]->getColor();
-
-        // update the color to return
-        color_to_return = color_to_return + color_value;
       }
+      color_to_return = color_to_return + sampled;
+    } else {
+      // for each light source, then for each spot light
+      addLights(line, hit, color_at_intersection_point, lights,
+                culling ? &light_indices : NULL, scene, color_to_return);
+      addLights(line, hit, color_at_intersection_point, spot_lights,
+                culling ? &spot_light_indices : NULL, scene,
+                color_to_return);
     }
 
     // reflection
-    if (current_level < recursion_level) {
+    if (current_level < view.recursion_level) {
       // find the normal at the intersection point of the reflected line
-      Line normal_line = getNormal(intersection_point, line);
+      Vector3D normal = hit.getNormal(line.getDirection());
       // need to find the reflection vector
-      double dot_product =
-          normal_line.getDirection().dot_product(line.getDirection());
+      double dot_product = normal.dot_product(line.getDirection());
       Vector3D reflection_vector =
-          line.getDirection() - (normal_line.getDirection() * 2) * dot_product;
+          line.getDirection() - (normal * 2) * dot_product;
       Line reflection_line(intersection_point, reflection_vector);
 
       // move forward a little bit to avoid self intersection
@@ -252,22 +339,21 @@ class Shape {
       // assgin the new intersection point as teh start point of the line
       reflection_line.setStart(new_intersection_point);
 
-      int nearest_shape_index = -1;
-      double nearest_t = 1000000000;
-      for (int i = 0; i < shapes.size(); i++) {
-        double other_t = shapes[i]->getT(reflection_line);
-        if (other_t > 0 && other_t < nearest_t) {
-          nearest_t = other_t;
-          nearest_shape_index = i;
-        }
-      }
+      thread_statistics.reflection_rays++;
+      HitRecord reflection_hit;
+      Shape* nearest_shape =
+          scene.closestHit(reflection_line, 1000000000, reflection_hit);
 
       // if there is an intersection
-      if (nearest_shape_index != -1) {
+      if (nearest_shape != NULL) {
+        thread_statistics.reflection_hits++;
         Color color_temporary(0, 0, 0);
-        double t_temporary = shapes[nearest_shape_index]->intersect(
-            reflection_line, lights, spot_lights, shapes, color_temporary,
-            current_level + 1, recursion_level);
+        // every level is timed by its caller
+        unsigned long long start_ticks = read_ticks();
+        nearest_shape->intersect(reflection_line, reflection_hit, context,
+                                 color_temporary, current_level + 1);
+        thread_statistics.addLevel(current_level + 1, 1,
+                                   read_ticks() - start_ticks);
 
         // update the color to return with the reflection color
         color_to_return =
@@ -278,10 +364,56 @@ class Shape {
     return t;
   }
 
-  virtual Line getNormal(Vector3D& intersection_point, Line line) = 0;
+  // the methods below are called concurrently by the render threads, they
+  // must only read the state of the shape
   virtual double getT(Line& line) = 0;
+  virtual ShapeType getType() = 0;
   virtual Color getColorAt(Vector3D& intersection_point) = 0;
+  virtual AABB getBoundingBox() = 0;
   virtual void draw() = 0;
+
+  /**
+   * @brief find the hit of the line with t_min < t < t_max and fill in
+   * everything the shading needs about it in one pass
+   * @param line the incident line
+   * @param t_min the near end of the interval that is searched
+   * @param t_max the far end of the interval that is searched
+   * @param hit filled with the hit, shape is left to the caller
+   * @return true if there is a hit in the interval
+   */
+  virtual bool intersect(Line& line,
+                         double t_min,
+                         double t_max,
+                         HitRecord& hit) = 0;
+
+  /**
+   * @brief the color at a hit, shapes with surface coordinates override
+   * this to use them instead of the point
+   */
+  virtual Color getColorAt(HitRecord& hit) { return getColorAt(hit.point); }
+
+  /**
+   * @brief check if the shape is hit with 0 < t < t_max
+   * used for shadow rays, which only need to know that something is in the
+   * way, composite shapes can stop at the first primitive that is hit
+   */
+  virtual bool occluded(Line& line, double t_max) {
+    double t = getT(line);
+    return t > 0 && t < t_max;
+  }
+
+  /**
+   * @brief getT for every ray of a packet
+   * shapes with a SIMD kernel override this, it must give exactly the t that
+   * getT gives for each ray on its own
+   * @param packet the rays
+   * @param t set to the distance of the hit (or -1) of every lane
+   */
+  virtual void getT(RayPacket& packet, double t[SIMD_WIDTH]) {
+    for (int i = 0; i < SIMD_WIDTH; i++) {
+      t[i] = getT(*packet.lines[i]);
+    }
+  }
 };
 
 #endif  // SHAPE_H
@@ -0,0 +1,319 @@
+/**
+ * @file simd.cpp
+ * @brief This file contains a 4 wide double precision vector type
+ * it maps to one AVX register, to two SSE2 registers or to a plain array,
+ * depending on what the compiler is allowed to use (-mavx2 / -msse2). every
+ * operation is the correctly rounded IEEE operation on each lane, so a kernel
+ * written with it gives exactly the same numbers as the scalar code it copies.
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+// number of lanes of Double4
+#define SIMD_WIDTH 4
+
+/**
+ * @brief The Mask4 class
+ * result of a lane wise comparison
+ */
+struct Mask4 {
+#if defined(__AVX__)
+  __m256d m;
+#elif defined(__SSE2__)
+  __m128d lo, hi;
+#else
+  bool m[4];
+#endif
+
+  /**
+   * @brief lanes that are set in both masks
+   */
+  Mask4 operator&(const Mask4& other) const {
+    Mask4 result;
+#if defined(__AVX__)
+    result.m = _mm256_and_pd(m, other.m);
+#elif defined(__SSE2__)
+    result.lo = _mm_and_pd(lo, other.lo);
+    result.hi = _mm_and_pd(hi, other.hi);
+#else
+    for (int i = 0; i < 4; i++) {
+      result.m[i] = m[i] && other.m[i];
+    }
+#endif
+    return result;
+  }
+
+  /**
+   * @brief lanes that are set in either mask
+   */
+  Mask4 operator|(const Mask4& other) const {
+    Mask4 result;
+#if defined(__AVX__)
+    result.m = _mm256_or_pd(m, other.m);
+#elif defined(__SSE2__)
+    result.lo = _mm_or_pd(lo, other.lo);
+    result.hi = _mm_or_pd(hi, other.hi);
+#else
+    for (int i = 0; i < 4; i++) {
+      result.m[i] = m[i] || other.m[i];
+    }
+#endif
+    return result;
+  }
+
+  /**
+   * @brief bit i of the result is set if lane i is set
+   */
+  int bits() const {
+#if defined(__AVX__)
+    return _mm256_movemask_pd(m);
+#elif defined(__SSE2__)
+    return _mm_movemask_pd(lo) | (_mm_movemask_pd(hi) << 2);
+#else
+    return m[0] | (m[1] << 1) | (m[2] << 2) | (m[3] << 3);
+#endif
+  }
+};
+
+/**
+ * @brief The Double4 class
+ * four doubles that are operated on together
+ */
+struct Double4 {
+#if defined(__AVX__)
+  __m256d v;
+#elif defined(__SSE2__)
+  __m128d lo, hi;
+#else
+  double v[4];
+#endif
+
+  Double4() {}
+
+  /**
+   * @brief the same value in every lane
+   */
+  Double4(double value) {
+#if defined(__AVX__)
+    v = _mm256_set1_pd(value);
+#elif defined(__SSE2__)
+    lo = hi = _mm_set1_pd(value);
+#else
+    for (int i = 0; i < 4; i++) {
+      v[i] = value;
+    }
+#endif
+  }
+
+  /**
+   * @brief load four consecutive doubles
+   */
+  static Double4 load(const double* values) {
+    Double4 result;
+#if defined(__AVX__)
+    result.v = _mm256_loadu_pd(values);
+#elif defined(__SSE2__)
+    result.lo = _mm_loadu_pd(values);
+    result.hi = _mm_loadu_pd(values + 2);
+#else
+    for (int i = 0; i < 4; i++) {
+      result.v[i] = values[i];
+    }
+#endif
+    return result;
+  }
+
+  /**
+   * @brief load four consecutive bytes, each converted to a double
+   */
+  static Double4 load(const unsigned char* values) {
+    Double4 result;
+    int bytes;
+    memcpy(&bytes, values, sizeof(bytes));
+#if defined(__AVX__)
+    result.v =
+        _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes)));
+#elif defined(__SSE2__)
+    __m128i zero = _mm_setzero_si128();
+    __m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero);
+    __m128i integers = _mm_unpacklo_epi16(words, zero);
+    result.lo = _mm_cvtepi32_pd(integers);
+    result.hi = _mm_cvtepi32_pd(_mm_srli_si128(integers, 8));
+#else
+    for (int i = 0; i < 4; i++) {
+      result.v[i] = values[i];
+    }
+#endif
+    return result;
+  }
+
+  /**
+   * @brief store the four lanes to consecutive doubles
+   */
+  void store(double* values) const {
+#if defined(__AVX__)
+    _mm256_storeu_pd(values, v);
+#elif defined(__SSE2__)
+    _mm_storeu_pd(values, lo);
+    _mm_storeu_pd(values + 2, hi);
+#else
+    for (int i = 0; i < 4; i++) {
+      values[i] = v[i];
+    }
+#endif
+  }
+
+#if defined(__AVX__)
+#define SIMD_BINARY(op, avx, sse, expression)   \
+  Double4 operator op(const Double4& b) const { \
+    Double4 result;                             \
+    result.v = avx(v, b.v);                     \
+    return result;                              \
+  }
+#elif defined(__SSE2__)
+#define SIMD_BINARY(op, avx, sse, expression)   \
+  Double4 operator op(const Double4& b) const { \
+    Double4 result;                             \
+    result.lo = sse(lo, b.lo);                  \
+    result.hi = sse(hi, b.hi);                  \
+    return result;                              \
+  }
+#else
+#define SIMD_BINARY(op, avx, sse, expression)   \
+  Double4 operator op(const Double4& b) const { \
+    Double4 result;                             \
+    for (int i = 0; i < 4; i++) {               \
+      result.v[i] = expression;                 \
+    }                                           \
+    return result;                              \
+  }
+#endif
+
+  SIMD_BINARY(+, _mm256_add_pd, _mm_add_pd, v[i] + b.v[i])
+  SIMD_BINARY(-, _mm256_sub_pd, _mm_sub_pd, v[i] - b.v[i])
+  SIMD_BINARY(*, _mm256_mul_pd, _mm_mul_pd, v[i] * b.v[i])
+  SIMD_BINARY(/, _mm256_div_pd, _mm_div_pd, v[i] / b.v[i])
+
+#undef SIMD_BINARY
+
+#if defined(__AVX__)
+#define SIMD_COMPARE(op, predicate, sse, expression) \
+  Mask4 operator op(const Double4& b) const {        \
+    Mask4 result;                                    \
+    result.m = _mm256_cmp_pd(v, b.v, predicate);     \
+    return result;                                   \
+  }
+#elif defined(__SSE2__)
+#define SIMD_COMPARE(op, predicate, sse, expression) \
+  Mask4 operator op(const Double4& b) const {        \
+    Mask4 result;                                    \
+    result.lo = sse(lo, b.lo);                       \
+    result.hi = sse(hi, b.hi);                       \
+    return result;                                   \
+  }
+#else
+#define SIMD_COMPARE(op, predicate, sse, expression) \
+  Mask4 operator op(const Double4& b) const {        \
+    Mask4 result;                                    \
+    for (int i = 0; i < 4; i++) {                    \
+      result.m[i] = expression;                      \
+    }                                                \
+    return result;                                   \
+  }
+#endif
+
+  // ordered comparisons, a lane holding NaN compares false
+  SIMD_COMPARE(<, _CMP_LT_OQ, _mm_cmplt_pd, v[i] < b.v[i])
+  SIMD_COMPARE(<=, _CMP_LE_OQ, _mm_cmple_pd, v[i] <= b.v[i])
+  SIMD_COMPARE(>, _CMP_GT_OQ, _mm_cmpgt_pd, v[i] > b.v[i])
+
+#undef SIMD_COMPARE
+};
+
+/**
+ * @brief square root of every lane
+ */
+inline Double4 sqrt(const Double4& a) {
+  Double4 result;
+#if defined(__AVX__)
+  result.v = _mm256_sqrt_pd(a.v);
+#elif defined(__SSE2__)
+  result.lo = _mm_sqrt_pd(a.lo);
+  result.hi = _mm_sqrt_pd(a.hi);
+#else
+  for (int i = 0; i < 4; i++) {
+    result.v[i] = std::sqrt(a.v[i]);
+  }
+#endif
+  return result;
+}
+
+/**
+ * @brief lane wise a < b ? a : b, a lane where either is NaN gives b
+ */
+inline Double4 min(const Double4& a, const Double4& b) {
+  Double4 result;
+#if defined(__AVX__)
+  result.v = _mm256_min_pd(a.v, b.v);
+#elif defined(__SSE2__)
+  result.lo = _mm_min_pd(a.lo, b.lo);
+  result.hi = _mm_min_pd(a.hi, b.hi);
+#else
+  for (int i = 0; i < 4; i++) {
+    result.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+  }
+#endif
+  return result;
+}
+
+/**
+ * @brief lane wise a > b ? a : b, a lane where either is NaN gives b
+ */
+inline Double4 max(const Double4& a, const Double4& b) {
+  Double4 result;
+#if defined(__AVX__)
+  result.v = _mm256_max_pd(a.v, b.v);
+#elif defined(__SSE2__)
+  result.lo = _mm_max_pd(a.lo, b.lo);
+  result.hi = _mm_max_pd(a.hi, b.hi);
+#else
+  for (int i = 0; i < 4; i++) {
+    result.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+  }
+#endif
+  return result;
+}
+
+/**
+ * @brief lane wise mask ? a : b
+ */
+inline Double4 select(const Mask4& mask, const Double4& a, const Double4& b) {
+  Double4 result;
+#if defined(__AVX__)
+  result.v = _mm256_blendv_pd(b.v, a.v, mask.m);
+#elif defined(__SSE2__)
+  result.lo = _mm_or_pd(_mm_and_pd(mask.lo, a.lo),
+                        _mm_andnot_pd(mask.lo, b.lo));
+  result.hi = _mm_or_pd(_mm_and_pd(mask.hi, a.hi),
+                        _mm_andnot_pd(mask.hi, b.hi));
+#else
+  for (int i = 0; i < 4; i++) {
+    result.v[i] = mask.m[i] ? a.v[i] : b.v[i];
+  }
+#endif
+  return result;
+}
+
+#endif  // SIMD_H
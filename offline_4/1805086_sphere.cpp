@@ -6,7 +6,9 @@
 #ifndef SPHERE_H
 #define SPHERE_H
 
+#ifndef HEADLESS
 #include <GL/glut.h>  // GLUT, includes glu.h and gl.h
+#endif
 
 #include "1805086_line.cpp"
 #include "1805086_shape.cpp"
@@ -41,19 +43,6 @@ class Sphere : public Shape {
   double getRadius() { return radius; }
   void setRadius(double radius) { this->radius = radius; }
 
-  /**
-   * @overridden
-   * @brief returns the normal vector of the sphere
-   * @param intersection_point the point of intersection
-   * @param line the incident line
-   */
-  virtual Line getNormal(Vector3D& intersection_point, Line line) {
-    // the normal vector is the vector from the center of the sphere to the
-    // point of intersection
-    Vector3D normal = intersection_point - position;
-    return Line(intersection_point, normal);
-  }
-
   /**
    * @brief returns the intersection point of the line with the sphere
    * @param line the incident line
@@ -102,11 +91,99 @@ class Sphere : public Shape {
     return t;
   }
 
+  /**
+   * @overridden
+   * @brief fills in the hit of the line with the sphere
+   * the sphere has no surface coordinates, u and v are left at 0
+   */
+  virtual bool intersect(Line& line,
+                         double t_min,
+                         double t_max,
+                         HitRecord& hit) {
+    double t = getT(line);
+    if (!(t > t_min && t < t_max)) {
+      return false;
+    }
+    hit.t = t;
+    hit.point = line.getPoint(t);
+    // the normal vector is the vector from the center of the sphere to the
+    // point of intersection
+    hit.normal = hit.point - position;
+    hit.normal.normalize();
+    hit.two_sided = false;
+    hit.primitive = -1;
+    hit.u = 0;
+    hit.v = 0;
+    return true;
+  }
+
+  /**
+   * @overridden
+   * @brief getT for a packet of rays, the same arithmetic as getT done on
+   * every lane at once
+   * @param packet the rays
+   * @param t set to the distance of the hit (or -1) of every lane
+   */
+  virtual void getT(RayPacket& packet, double t[SIMD_WIDTH]) {
+    Double4 start[3], direction[3];
+    for (int i = 0; i < 3; i++) {
+      start[i] = packet.getOrigin(i) - Double4(position[i]);
+      direction[i] = packet.getDirection(i);
+    }
+    // getT normalizes the direction once more when it builds adjusted_line
+    Double4 length = sqrt(direction[0] * direction[0] +
+                          direction[1] * direction[1] +
+                          direction[2] * direction[2]);
+    for (int i = 0; i < 3; i++) {
+      direction[i] = direction[i] / length;
+    }
+
+    Double4 b = Double4(2.0) * (direction[0] * start[0] +
+                                direction[1] * start[1] +
+                                direction[2] * start[2]);
+    Double4 c = start[0] * start[0] + start[1] * start[1] +
+                start[2] * start[2] - Double4(radius * radius);
+    Double4 discriminant = b * b - Double4(4.0) * c;
+
+    Double4 zero(0.0);
+    Double4 minus_b = zero - b;
+    Double4 root = sqrt(discriminant);
+    Double4 t1 = (minus_b + root) / Double4(2.0);
+    Double4 t2 = (minus_b - root) / Double4(2.0);
+    Mask4 t1_positive = t1 > zero;
+    Mask4 t2_positive = t2 > zero;
+    // the smaller positive root, or -1
+    Double4 result = select(t2_positive, t2, Double4(-1.0));
+    result = select(t1_positive, t1, result);
+    result = select(t1_positive & t2_positive, min(t2, t1), result);
+    // a (nearly) touching ray
+    result = select(discriminant < Double4(0.00001), minus_b / Double4(2.0),
+                    result);
+    result = select(discriminant < zero, Double4(-1.0), result);
+    result.store(t);
+  }
+
+  /**
+   * @overridden
+   * @brief returns the kind of the shape
+   */
+  virtual ShapeType getType() { return SHAPE_SPHERE; }
+
+  /**
+   * @overridden
+   * @brief returns the bounding box of the sphere
+   */
+  virtual AABB getBoundingBox() {
+    return AABB(position - Vector3D(radius, radius, radius),
+                position + Vector3D(radius, radius, radius));
+  }
+
   /**
    * @overridden
    * @brief draw the sphere
    */
   virtual void draw() {
+#ifndef HEADLESS
     // save the current state of OpenGL
     glPushMatrix();
     // translate to the position of the sphere
@@ -117,6 +194,7 @@ class Sphere : public Shape {
     glutSolidSphere(radius, 100, 100);
     // restore the state of OpenGL
     glPopMatrix();
+#endif
   }
 
   /**
@@ -124,7 +202,7 @@ class Sphere : public Shape {
    * @brief returns the color of the sphere at the intersection point
    * @param intersection_point the point of intersection
    */
-  virtual Color getColorAt(Vector3D& intersection_point) {
+  virtual Color getColorAt(Vector3D& /*intersection_point*/) {
     // the color of the sphere is the color of the sphere
     return color;
   }
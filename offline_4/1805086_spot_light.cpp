@@ -6,7 +6,11 @@
 #ifndef SPOT_LIGHT_H
 #define SPOT_LIGHT_H
 
+#ifndef HEADLESS
 #include <GL/glut.h>  // GLUT, includes glu.h and gl.h
+#endif
+
+#include <cmath>
 
 #include "1805086_color.cpp"
 #include "1805086_light.cpp"
@@ -18,6 +22,25 @@ class SpotLight : public Light {
   /* data */
   Vector3D direction;
   double angle;
+  // the cone test of every hit compares against these instead of angles
+  Vector3D unit_direction;
+  double cos_angle;
+
+  /**
+   * @brief derive the unit direction and the cosine of the angle
+   * an angle of 180 degrees or more lights every direction, a negative one
+   * none
+   */
+  void updateCone() {
+    unit_direction = direction * (1 / direction.length());
+    if (angle >= 180) {
+      cos_angle = -INFINITY;
+    } else if (angle < 0) {
+      cos_angle = INFINITY;
+    } else {
+      cos_angle = cos(angle * M_PI / 180);
+    }
+  }
 
  public:
   /**
@@ -34,13 +57,15 @@ class SpotLight : public Light {
             double falloff,
             Vector3D direction,
             double angle)
-      : Light(position, color, falloff), direction(direction), angle(angle) {}
+      : Light(position, color, falloff), direction(direction), angle(angle) {
+    updateCone();
+  }
 
   /**
    * @brief Construct a new Spot Light object
    *
    */
-  SpotLight() : Light(), direction(Vector3D()), angle(0) {}
+  SpotLight() : Light(), direction(Vector3D()), angle(0) { updateCone(); }
 
   /**
    * @brief Get the Direction object
@@ -61,14 +86,33 @@ class SpotLight : public Light {
    *
    * @param direction
    */
-  void setDirection(Vector3D direction) { this->direction = direction; }
+  void setDirection(Vector3D direction) {
+    this->direction = direction;
+    updateCone();
+  }
 
   /**
    * @brief Set the Angle object
    *
    * @param angle
    */
-  void setAngle(double angle) { this->angle = angle; }
+  void setAngle(double angle) {
+    this->angle = angle;
+    updateCone();
+  }
+
+  /**
+   * @brief whether a point is inside the cone of the light
+   * the same as direction.angle(to_point) in degrees <= angle, a point at
+   * the light itself or a light without a direction lights everything
+   *
+   * @param to_point from the light to the point
+   * @param distance the length of to_point
+   * @return bool
+   */
+  bool isInCone(const Vector3D& to_point, double distance) const {
+    return !(unit_direction.dot_product(to_point) < cos_angle * distance);
+  }
 
   ~SpotLight() {}
 };
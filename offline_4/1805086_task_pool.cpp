@@ -0,0 +1,126 @@
+/**
+ * @file task_pool.cpp
+ * @brief This file contains a pool of threads that run submitted tasks
+ * used to build the bounding volume hierarchy in parallel. a thread that has
+ * to wait for its tasks runs queued tasks itself in the meantime, so tasks
+ * can submit and wait for tasks of their own without running out of
+ * threads.
+ */
+
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief The TaskPool class
+ */
+class TaskPool {
+ private:
+  mutex lock;
+  condition_variable wake;
+  deque<function<void()>> tasks;
+  vector<thread> workers;
+  bool stopping;
+
+  /**
+   * @brief take the oldest task off the queue
+   * @return false if the queue is empty
+   */
+  bool take(function<void()>& task) {
+    lock_guard<mutex> guard(lock);
+    if (tasks.empty()) {
+      return false;
+    }
+    task = move(tasks.front());
+    tasks.pop_front();
+    return true;
+  }
+
+  void work() {
+    while (true) {
+      function<void()> task;
+      {
+        unique_lock<mutex> guard(lock);
+        wake.wait(guard, [&]() { return stopping || !tasks.empty(); });
+        if (tasks.empty()) {
+          return;
+        }
+        task = move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+ public:
+  /**
+   * @brief start the workers
+   * @param number_of_threads the threads that run tasks, including the one
+   * that waits for them, so one thread starts no worker at all
+   */
+  TaskPool(int number_of_threads) : stopping(false) {
+    for (int i = 1; i < number_of_threads; i++) {
+      workers.push_back(thread(&TaskPool::work, this));
+    }
+  }
+
+  /**
+   * @brief finish the queued tasks and stop the workers
+   */
+  ~TaskPool() {
+    {
+      lock_guard<mutex> guard(lock);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (thread& worker : workers) {
+      worker.join();
+    }
+    function<void()> task;
+    while (take(task)) {
+      task();
+    }
+  }
+
+  /**
+   * @brief the number of threads that run tasks
+   */
+  int getThreadCount() { return workers.size() + 1; }
+
+  /**
+   * @brief queue a task, it runs on a worker or on a waiting thread
+   */
+  void submit(function<void()> task) {
+    {
+      lock_guard<mutex> guard(lock);
+      tasks.push_back(move(task));
+    }
+    wake.notify_one();
+  }
+
+  /**
+   * @brief run queued tasks until a counter of unfinished tasks reaches 0
+   * @param pending decremented by each task when it is done
+   */
+  void wait(atomic<int>& pending) {
+    while (pending.load() > 0) {
+      function<void()> task;
+      if (take(task)) {
+        task();
+      } else {
+        this_thread::yield();
+      }
+    }
+  }
+};
+
+#endif  // TASK_POOL_H
@@ -0,0 +1,153 @@
+/**
+ * @file tile_renderer.cpp
+ * @brief This file contains the tile scheduler used by the renderer
+ * the frame is split into square tiles which are handed out to a pool of
+ * worker threads. each worker owns a queue of tiles and steals from the back
+ * of the other queues once its own queue runs dry.
+ */
+
+#ifndef TILE_RENDERER_H
+#define TILE_RENDERER_H
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief a rectangular block of pixels [x0, x1) x [y0, y1)
+ */
+struct Tile {
+  int x0, y0;
+  int x1, y1;
+};
+
+/**
+ * @brief The TileScheduler class
+ * work stealing scheduler handing out tiles to the worker threads
+ */
+class TileScheduler {
+ private:
+  /**
+   * @brief the queue of tiles owned by one worker
+   */
+  struct WorkerQueue {
+    mutex lock;
+    deque<Tile> tiles;
+  };
+
+  vector<WorkerQueue> queues;
+
+  /**
+   * @brief pop a tile from the front of the worker's own queue
+   */
+  bool popOwn(int worker, Tile& tile) {
+    WorkerQueue& queue = queues[worker];
+    lock_guard<mutex> guard(queue.lock);
+    if (queue.tiles.empty()) {
+      return false;
+    }
+    tile = queue.tiles.front();
+    queue.tiles.pop_front();
+    return true;
+  }
+
+  /**
+   * @brief steal a tile from the back of another worker's queue
+   */
+  bool steal(int worker, Tile& tile) {
+    int number_of_queues = queues.size();
+    for (int i = 1; i < number_of_queues; i++) {
+      WorkerQueue& victim = queues[(worker + i) % number_of_queues];
+      lock_guard<mutex> guard(victim.lock);
+      if (!victim.tiles.empty()) {
+        tile = victim.tiles.back();
+        victim.tiles.pop_back();
+        return true;
+      }
+    }
+    return false;
+  }
+
+ public:
+  /**
+   * @brief split the frame into tiles and deal them out to the workers
+   * each worker gets a contiguous run of tiles so neighbouring pixels are
+   * shaded by the same thread as long as nobody has to steal
+   * @param width the width of the frame
+   * @param height the height of the frame
+   * @param tile_size the side length of a tile in pixels
+   * @param number_of_workers the number of worker queues
+   */
+  TileScheduler(int width, int height, int tile_size, int number_of_workers)
+      : queues(number_of_workers) {
+    vector<Tile> tiles;
+    for (int y = 0; y < height; y += tile_size) {
+      for (int x = 0; x < width; x += tile_size) {
+        Tile tile;
+        tile.x0 = x;
+        tile.y0 = y;
+        tile.x1 = min(x + tile_size, width);
+        tile.y1 = min(y + tile_size, height);
+        tiles.push_back(tile);
+      }
+    }
+
+    for (int i = 0; i < tiles.size(); i++) {
+      int worker = (long long)i * number_of_workers / tiles.size();
+      queues[worker].tiles.push_back(tiles[i]);
+    }
+  }
+
+  /**
+   * @brief get the next tile for a worker
+   * @param worker the index of the worker asking for work
+   * @param tile the tile to render
+   * @return false when every queue is empty
+   */
+  bool next(int worker, Tile& tile) {
+    return popOwn(worker, tile) || steal(worker, tile);
+  }
+};
+
+/**
+ * @brief render a frame tile by tile on a pool of worker threads
+ * with a single thread the tiles are rendered on the calling thread
+ * @param width the width of the frame
+ * @param height the height of the frame
+ * @param tile_size the side length of a tile in pixels
+ * @param number_of_threads the number of worker threads
+ * @param render_tile called once for every tile, from any worker
+ */
+void render_tiles(int width,
+                  int height,
+                  int tile_size,
+                  int number_of_threads,
+                  const function<void(const Tile&)>& render_tile) {
+  if (number_of_threads < 1) {
+    number_of_threads = 1;
+  }
+  TileScheduler scheduler(width, height, tile_size, number_of_threads);
+
+  auto worker = [&](int index) {
+    Tile tile;
+    while (scheduler.next(index, tile)) {
+      render_tile(tile);
+    }
+  };
+
+  vector<thread> threads;
+  for (int i = 1; i < number_of_threads; i++) {
+    threads.push_back(thread(worker, i));
+  }
+  // the calling thread is worker 0
+  worker(0);
+  for (int i = 0; i < threads.size(); i++) {
+    threads[i].join();
+  }
+}
+
+#endif  // TILE_RENDERER_H
@@ -6,24 +6,107 @@
 #ifndef TRIANGLE_H
 #define TRIANGLE_H
 
+#ifndef HEADLESS
 #include <GL/glut.h>  // GLUT, includes glu.h and gl.h
+#endif
 
 #include "1805086_shape.cpp"
+#include "1805086_simd.cpp"
 #include "1805086_vector3d.cpp"
 
+/**
+ * @brief Moller-Trumbore ray triangle test on four lanes at once
+ * every lane is either four rays against one triangle or one ray against four
+ * triangles, the arithmetic is the same as in Triangle::getT
+ * @param start the start of the ray(s)
+ * @param direction the direction of the ray(s)
+ * @param v1 the first vertex of the triangle(s)
+ * @param edge1 v2 - v1
+ * @param edge2 v3 - v1
+ * @return the distance of the hit (or -1) of every lane
+ */
+inline Double4 moller_trumbore(const Double4 start[3],
+                               const Double4 direction[3],
+                               const Double4 v1[3],
+                               const Double4 edge1[3],
+                               const Double4 edge2[3]) {
+  // p = direction x edge2
+  Double4 p[3] = {direction[1] * edge2[2] - direction[2] * edge2[1],
+                  direction[2] * edge2[0] - direction[0] * edge2[2],
+                  direction[0] * edge2[1] - direction[1] * edge2[0]};
+  Double4 det = edge1[0] * p[0] + edge1[1] * p[1] + edge1[2] * p[2];
+  Double4 inverse_det = Double4(1.0) / det;
+
+  Double4 s[3] = {start[0] - v1[0], start[1] - v1[1], start[2] - v1[2]};
+  Double4 u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse_det;
+
+  // q = s x edge1
+  Double4 q[3] = {s[1] * edge1[2] - s[2] * edge1[1],
+                  s[2] * edge1[0] - s[0] * edge1[2],
+                  s[0] * edge1[1] - s[1] * edge1[0]};
+  Double4 v =
+      (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) *
+      inverse_det;
+  Double4 t = (edge2[0] * q[0] + edge2[1] * q[1] + edge2[2] * q[2]) *
+              inverse_det;
+
+  Double4 zero(0.0);
+  Double4 one(1.0);
+  Mask4 hit = ((det < zero) | (zero < det)) & (zero < u) & (u < one) &
+              (zero < v) & (u + v < one) & (zero < t);
+  return select(hit, t, Double4(-1.0));
+}
+
 class Triangle : public Shape {
  private:
   // the three vertices of the triangle
   Vector3D v1, v2, v3;
+  // computed once from the vertices
+  Vector3D edge1;   // v2 - v1
+  Vector3D edge2;   // v3 - v1
+  Vector3D normal;  // unit normal, edge1 x edge2
 
-  // calculate the determinant of a 3x3 matrix
-  double determinant(double matrix[3][3]) {
-    return matrix[0][0] *
-               (matrix[1][1] * matrix[2][2] - matrix[1][2] * matrix[2][1]) -
-           matrix[0][1] *
-               (matrix[1][0] * matrix[2][2] - matrix[1][2] * matrix[2][0]) +
-           matrix[0][2] *
-               (matrix[1][0] * matrix[2][1] - matrix[1][1] * matrix[2][0]);
+  // compute the edges and the normal from the vertices
+  void precompute() {
+    edge1 = v2 - v1;
+    edge2 = v3 - v1;
+    normal = edge1 * edge2;
+    normal.normalize();
+  }
+
+  /**
+   * Moller-Trumbore: solves start + t * direction = v1 + u * edge1 + v *
+   * edge2, rejecting as soon as u or v leave the triangle. the tests are
+   * written so that NaN is rejected as well
+   * @return t, or -1 if the triangle is not hit
+   */
+  double hit(Line& ray, double& u, double& v) {
+    Vector3D direction = ray.getDirection();
+    Vector3D p = direction * edge2;
+    double det = edge1.dot_product(p);
+    // the line is parallel to the triangle
+    if (!(det < 0 || 0 < det)) {
+      return -1;
+    }
+    double inverse_det = 1.0 / det;
+
+    Vector3D s = ray.getStart() - v1;
+    u = s.dot_product(p) * inverse_det;
+    if (!(0 < u && u < 1)) {
+      return -1;
+    }
+
+    Vector3D q = s * edge1;
+    v = direction.dot_product(q) * inverse_det;
+    if (!(0 < v && u + v < 1)) {
+      return -1;
+    }
+
+    double t = edge2.dot_product(q) * inverse_det;
+    if (!(0 < t)) {
+      return -1;
+    }
+    return t;
   }
 
  public:
@@ -48,7 +131,9 @@ class Triangle : public Shape {
               specular_exponent),
         v1(v1),
         v2(v2),
-        v3(v3) {}
+        v3(v3) {
+    precompute();
+  }
 
   /**
    * @brief empty constructor
@@ -57,24 +142,28 @@ class Triangle : public Shape {
       : Shape(),
         v1(Vector3D(1, 0, 0)),
         v2(Vector3D(0, 1, 0)),
-        v3(Vector3D(0, 0, 1)) {}
+        v3(Vector3D(0, 0, 1)) {
+    precompute();
+  }
+
+  Vector3D getVertex1() { return v1; }
+  Vector3D getEdge1() { return edge1; }
+  Vector3D getEdge2() { return edge2; }
+  Vector3D getNormal() { return normal; }
 
   /**
    * @brief returns the area of the triangle
    *
    * @return double
    */
-  double area() {
-    Vector3D v12 = v2 - v1;
-    Vector3D v13 = v3 - v1;
-    return 0.5 * (v12 * v13).length();
-  }
+  double area() { return 0.5 * (edge1 * edge2).length(); }
 
   /**
    * @overridden
    * @brief draw the triangle
    */
   void draw() {
+#ifndef HEADLESS
     glBegin(GL_TRIANGLES);
     {
       glVertex3f(v1[0], v1[1], v1[2]);
@@ -82,92 +171,93 @@ class Triangle : public Shape {
       glVertex3f(v3[0], v3[1], v3[2]);
     }
     glEnd();
+#endif
   }
   /**
    * @overridden
-   * @brief returns the normal vector of the triangle
-   * @param intersection_point the point of intersection
-   * @param line the incident line
+   * @brief returns the point of intersection of the triangle and the line
+   * @param ray the incident line
    */
-  Line getNormal(Vector3D& intersection_point, Line line) {
-    Vector3D v12 = v2 - v1;
-    Vector3D v13 = v3 - v1;
-    Vector3D normal = v12 * v13;
-    normal.normalize();
-
-    // check on which side of the triangle the line is
-    if (normal.dot_product(line.getDirection()) > 0) {
-      normal = normal * (-1);
+  double getT(Line& ray) {
+    double u, v;
+    return hit(ray, u, v);
+  }
+  /**
+   * @overridden
+   * @brief fills in the hit of the line with the triangle
+   * u and v are the barycentric coordinates of v2 and v3
+   */
+  bool intersect(Line& line, double t_min, double t_max, HitRecord& hit) {
+    double u, v;
+    double t = this->hit(line, u, v);
+    if (!(t > t_min && t < t_max)) {
+      return false;
     }
-
-    return Line(intersection_point, normal);
+    hit.t = t;
+    hit.point = line.getPoint(t);
+    hit.normal = normal;
+    hit.two_sided = true;
+    hit.primitive = -1;
+    hit.u = u;
+    hit.v = v;
+    return true;
   }
   /**
    * @overridden
-   * @brief returns the point of intersection of the triangle and the line
-   * @param ray the incident line
+   * @brief getT for a packet of rays, the same arithmetic as getT done on
+   * every lane at once
+   * @param packet the rays
+   * @param t set to the distance of the hit (or -1) of every lane
    */
-  double getT(Line& ray) {
-    // generate teh beta and gamma values
-    // martix B
-    double bMatrix[3][3] = {
-        {v1[0] - ray.getStart()[0], v1[0] - v3[0], ray.getDirection()[0]},
-        {v1[1] - ray.getStart()[1], v1[1] - v3[1], ray.getDirection()[1]},
-        {v1[2] - ray.getStart()[2], v1[2] - v3[2], ray.getDirection()[2]}};
-    // matrix gamma
-    double gammaMatrix[3][3] = {
-        {v1[0] - v2[0], v1[0] - ray.getStart()[0], ray.getDirection()[0]},
-        {v1[1] - v2[1], v1[1] - ray.getStart()[1], ray.getDirection()[1]},
-        {v1[2] - v2[2], v1[2] - ray.getStart()[2], ray.getDirection()[2]}};
-
-    // matrix t
-    double tMatrix[3][3] = {
-        {v1[0] - v2[0], v1[0] - v3[0], v1[0] - ray.getStart()[0]},
-        {v1[1] - v2[1], v1[1] - v3[1], v1[1] - ray.getStart()[1]},
-        {v1[2] - v2[2], v1[2] - v3[2], v1[2] - ray.getStart()[2]}};
-
-    // matrix A
-    double aMatrix[3][3] = {
-        {v1[0] - v2[0], v1[0] - v3[0], ray.getDirection()[0]},
-        {v1[1] - v2[1], v1[1] - v3[1], ray.getDirection()[1]},
-        {v1[2] - v2[2], v1[2] - v3[2], ray.getDirection()[2]}};
-
-    // calculate the determinants
-    double a = determinant(aMatrix);
-    double b = determinant(bMatrix) / a;
-    double gamma = determinant(gammaMatrix) / a;
-    double t = determinant(tMatrix) / a;
-    // check the following condition for intersection
-    // * b>0 and gamma>0 and b+gamma<1 and t>0
-    if (b > 0 && gamma > 0 && b + gamma < 1 && t > 0) {
-      return t;
-    } else {
-      return -1;
+  void getT(RayPacket& packet, double t[SIMD_WIDTH]) {
+    Double4 start[3], direction[3], vertex[3], e1[3], e2[3];
+    for (int i = 0; i < 3; i++) {
+      start[i] = packet.getOrigin(i);
+      direction[i] = packet.getDirection(i);
+      vertex[i] = Double4(v1[i]);
+      e1[i] = Double4(edge1[i]);
+      e2[i] = Double4(edge2[i]);
     }
+    moller_trumbore(start, direction, vertex, e1, e2).store(t);
   }
+
+  /**
+   * @overridden
+   * @brief returns the kind of the shape
+   */
+  ShapeType getType() { return SHAPE_TRIANGLE; }
+
+  /**
+   * @overridden
+   * @brief returns the bounding box of the triangle
+   */
+  AABB getBoundingBox() {
+    AABB box;
+    box.expand(v1);
+    box.expand(v2);
+    box.expand(v3);
+    return box;
+  }
+
   /**
    * @overridden
    * @brief returns the color of the triangle at the point of intersection
    * @param intersection_point the point of intersection
    */
-  Color getColorAt(Vector3D& intersection_point) { return color; }
+  Color getColorAt(Vector3D& /*intersection_point*/) { return color; }
 
   /**
    * @brief returns if a point is inside the triangle
    */
   bool inside(Vector3D& point) {
-    // calculate the vector representing the edges
-    Vector3D v12 = v2 - v1;
-    Vector3D v13 = v3 - v1;
-
-    // calculate the normal vector
-    Vector3D normal = v12 * v13;
+    // the normal vector that is not normalized
+    Vector3D cross = edge1 * edge2;
 
     // calculate the barycentric coordinates
-    double denominator = normal.length() * normal.length();
+    double denominator = cross.length() * cross.length();
     Vector3D d = point - v1;
-    double u = (d * v13).dot_product(normal) / denominator;
-    double v = (v12 * d).dot_product(normal) / denominator;
+    double u = (d * edge2).dot_product(cross) / denominator;
+    double v = (edge1 * d).dot_product(cross) / denominator;
 
     // check if the point is inside the triangle
     if (u >= 0 && v >= 0 && u + v <= 1) {
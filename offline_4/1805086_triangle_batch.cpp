@@ -0,0 +1,142 @@
+/**
+ * @file triangle_batch.cpp
+ * @brief This file contains a batch of triangles that is tested against one
+ * ray SIMD_WIDTH triangles at a time
+ * the vertices and edges are stored in structure of arrays layout, padded to
+ * a multiple of SIMD_WIDTH with degenerate triangles that are never hit.
+ */
+
+#ifndef TRIANGLE_BATCH_H
+#define TRIANGLE_BATCH_H
+
+#include <cmath>
+#include <vector>
+
+#include "1805086_line.cpp"
+#include "1805086_simd.cpp"
+#include "1805086_triangle.cpp"
+
+using namespace std;
+
+/**
+ * @brief The TriangleBatch class
+ */
+class TriangleBatch {
+ private:
+  int size;                 // number of triangles
+  vector<double> v1[3];     // first vertex, per coordinate
+  vector<double> edge1[3];  // v2 - v1, per coordinate
+  vector<double> edge2[3];  // v3 - v1, per coordinate
+
+  /**
+   * @brief the t of the ray against the triangles [first, first + SIMD_WIDTH)
+   */
+  Double4 intersect(const Double4 start[3],
+                    const Double4 direction[3],
+                    int first) {
+    Double4 vertex[3], e1[3], e2[3];
+    for (int i = 0; i < 3; i++) {
+      vertex[i] = Double4::load(&v1[i][first]);
+      e1[i] = Double4::load(&edge1[i][first]);
+      e2[i] = Double4::load(&edge2[i][first]);
+    }
+    return moller_trumbore(start, direction, vertex, e1, e2);
+  }
+
+  /**
+   * @brief the start and direction of the line in every lane
+   */
+  static void broadcast(Line& line, Double4 start[3], Double4 direction[3]) {
+    Vector3D line_start = line.getStart();
+    Vector3D line_direction = line.getDirection();
+    for (int i = 0; i < 3; i++) {
+      start[i] = Double4(line_start[i]);
+      direction[i] = Double4(line_direction[i]);
+    }
+  }
+
+ public:
+  /**
+   * @brief empty batch, nothing is ever hit
+   */
+  TriangleBatch() : size(0) {}
+
+  /**
+   * @brief copy the geometry of the triangles, in order
+   */
+  TriangleBatch(vector<Triangle*>& triangles) : size(triangles.size()) {
+    int padded_size = (size + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+    for (int i = 0; i < 3; i++) {
+      v1[i].assign(padded_size, 0);
+      edge1[i].assign(padded_size, 0);
+      edge2[i].assign(padded_size, 0);
+    }
+    for (int j = 0; j < size; j++) {
+      Vector3D vertex = triangles[j]->getVertex1();
+      Vector3D e1 = triangles[j]->getEdge1();
+      Vector3D e2 = triangles[j]->getEdge2();
+      for (int i = 0; i < 3; i++) {
+        v1[i][j] = vertex[i];
+        edge1[i][j] = e1[i];
+        edge2[i][j] = e2[i];
+      }
+    }
+  }
+
+  /**
+   * @brief find the nearest triangle hit by the line
+   * gives the same t as calling Triangle::getT on every triangle, ties go
+   * to the lower index
+   * @param line the ray
+   * @param t_min only hits with t_min < t < t_max count, t_min >= 0
+   * @param t_max only hits with t_min < t < t_max count
+   * @param t set to the distance of the nearest hit
+   * @return the index of the triangle or -1 if nothing is hit
+   */
+  int closestHitIndex(Line& line, double t_min, double t_max, double& t) {
+    Double4 start[3], direction[3];
+    broadcast(line, start, direction);
+
+    int nearest_index = -1;
+    double nearest_t = t_max;
+    for (int first = 0; first < size; first += SIMD_WIDTH) {
+      double lane_t[SIMD_WIDTH];
+      intersect(start, direction, first).store(lane_t);
+      for (int i = 0; i < SIMD_WIDTH; i++) {
+        // strictly nearer, so the lower index wins a tie
+        if (lane_t[i] > t_min && lane_t[i] < nearest_t) {
+          nearest_t = lane_t[i];
+          nearest_index = first + i;
+        }
+      }
+    }
+    t = nearest_t;
+    return nearest_index;
+  }
+
+  /**
+   * @brief check if any triangle is hit with 0 < t < t_max
+   * stops after the first group of SIMD_WIDTH triangles with a hit
+   */
+  bool occluded(Line& line, double t_max) {
+    Double4 start[3], direction[3];
+    broadcast(line, start, direction);
+
+    Double4 zero(0.0);
+    Double4 limit(t_max);
+    for (int first = 0; first < size; first += SIMD_WIDTH) {
+      Double4 lane_t = intersect(start, direction, first);
+      if (((zero < lane_t) & (lane_t < limit)).bits() != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief the number of triangles
+   */
+  int getSize() { return size; }
+};
+
+#endif  // TRIANGLE_BATCH_H
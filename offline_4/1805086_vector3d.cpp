@@ -13,17 +13,15 @@ using namespace std;
 
 /**
  * @brief The Vector3D class
+ * the coordinates are stored inline, so the class is trivially copyable and
+ * temporaries never touch the heap
  */
 class Vector3D {
-  vector<double> v;
+  double v[3];
 
  public:
-  Vector3D() : v(3) {}
-  Vector3D(double x, double y, double z) : v(3) {
-    v[0] = x;
-    v[1] = y;
-    v[2] = z;
-  }
+  Vector3D() : v{0, 0, 0} {}
+  Vector3D(double x, double y, double z) : v{x, y, z} {}
 
   /**
    * @brief overloaded function for []
@@ -33,12 +31,13 @@ class Vector3D {
    */
 
   double& operator[](int index) { return v[index]; }
+  const double& operator[](int index) const { return v[index]; }
 
   /**
    * @brief operator *
    * @param another_vector    the vector to be multiplied with (cross product)
    */
-  Vector3D operator*(Vector3D another_vector) {
+  Vector3D operator*(const Vector3D& another_vector) const {
     Vector3D result;
     result[0] = v[1] * another_vector[2] - v[2] * another_vector[1];
     result[1] = v[2] * another_vector[0] - v[0] * another_vector[2];
@@ -50,7 +49,7 @@ class Vector3D {
    * @brief dot_product
    * @param another_vector    the vector to be multiplied with (dot product)
    */
-  double dot_product(Vector3D another_vector) {
+  double dot_product(const Vector3D& another_vector) const {
     return v[0] * another_vector[0] + v[1] * another_vector[1] +
            v[2] * another_vector[2];
   }
@@ -60,7 +59,7 @@ class Vector3D {
    * @param another_vector    the vector to be added with
    */
 
-  Vector3D operator+(Vector3D another_vector) {
+  Vector3D operator+(const Vector3D& another_vector) const {
     Vector3D result;
     result[0] = v[0] + another_vector[0];
     result[1] = v[1] + another_vector[1];
@@ -72,7 +71,7 @@ class Vector3D {
    * @brief operator -
    * @param another_vector    the vector to be subtracted with
    */
-  Vector3D operator-(Vector3D another_vector) {
+  Vector3D operator-(const Vector3D& another_vector) const {
     Vector3D result;
     result[0] = v[0] - another_vector[0];
     result[1] = v[1] - another_vector[1];
@@ -84,7 +83,7 @@ class Vector3D {
    * @brief operator /
    * @param scalar    the scalar to be divided with
    */
-  Vector3D operator/(double scalar) {
+  Vector3D operator/(double scalar) const {
     Vector3D result;
     result[0] = v[0] / scalar;
     result[1] = v[1] / scalar;
@@ -96,7 +95,7 @@ class Vector3D {
    * @brief operator *
    * @param scalar    the scalar to be multiplied with
    */
-  Vector3D operator*(double scalar) {
+  Vector3D operator*(double scalar) const {
     Vector3D result;
     result[0] = v[0] * scalar;
     result[1] = v[1] * scalar;
@@ -104,22 +103,11 @@ class Vector3D {
     return result;
   }
 
-  /**
-   * @brief operator =
-   * @param another_vector    the vector to be assigned
-   */
-  Vector3D operator=(Vector3D another_vector) {
-    v[0] = another_vector[0];
-    v[1] = another_vector[1];
-    v[2] = another_vector[2];
-    return *this;
-  }
-
   /**
    * @brief operator ==
    * @param another_vector    the vector to be compared with
    */
-  bool operator==(Vector3D another_vector) {
+  bool operator==(const Vector3D& another_vector) const {
     return v[0] == another_vector[0] && v[1] == another_vector[1] &&
            v[2] == another_vector[2];
   }
@@ -137,26 +125,30 @@ class Vector3D {
   /**
    * @brief print
    */
-  void print() { cout << v[0] << " " << v[1] << " " << v[2] << endl; }
+  void print() const { cout << v[0] << " " << v[1] << " " << v[2] << endl; }
 
   /**
    * @brief get the vector double
    *
    */
-  vector<double> getCoordinates() { return this->v; }
+  vector<double> getCoordinates() const {
+    return vector<double>(v, v + 3);
+  }
 
   /**
    * @brief length of the vector
    * @return double
    */
-  double length() { return sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]); }
+  double length() const {
+    return sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+  }
 
   /**
    * @brief rotate this vector around another vector by an angle
    * @param axis              the vector to be rotated around
    * @param angle             the angle to be rotated by
    */
-  void rotate(Vector3D axis, double angle) {
+  void rotate(const Vector3D& axis, double angle) {
     Vector3D v1 = axis * (*this);
     *this = *this * cos(angle) + v1 * sin(angle);
   }
@@ -165,7 +157,7 @@ class Vector3D {
    * @param another_vector    the vector to be compared with
    * @return double
    */
-  double angle(Vector3D another_vector) {
+  double angle(const Vector3D& another_vector) const {
     return acos(this->dot_product(another_vector) /
                 (this->length() * another_vector.length()));
   }
@@ -0,0 +1,122 @@
+/**
+ * @file wide_node.cpp
+ * @brief This file contains the node of a wide bounding volume hierarchy
+ * a wide node holds the boxes of up to WIDTH children in structure of arrays
+ * layout, so that one ray is tested against SIMD_WIDTH of them with each
+ * Double4 operation. the nodes are aligned to cache lines and a node never
+ * shares a line with another.
+ */
+
+#ifndef WIDE_NODE_H
+#define WIDE_NODE_H
+
+#include <cmath>
+
+#include "1805086_aabb.cpp"
+#include "1805086_simd.cpp"
+
+using namespace std;
+
+/**
+ * @brief The WideNode struct
+ * a child is either another wide node (count == 0, child is its index) or a
+ * leaf (count > 0 primitives starting at child in the index array). the
+ * slots [size, WIDTH) are empty
+ */
+template <int WIDTH>
+struct alignas(64) WideNode {
+  static_assert(WIDTH % SIMD_WIDTH == 0, "a node is a whole number of Double4");
+
+  static const int SLOTS = WIDTH;
+
+  double low[3][WIDTH];
+  double high[3][WIDTH];
+  int child[WIDTH];
+  int count[WIDTH];
+  int size;
+
+  WideNode() : size(0) {
+    for (int i = 0; i < WIDTH; i++) {
+      for (int axis = 0; axis < 3; axis++) {
+        low[axis][i] = INFINITY;
+        high[axis][i] = -INFINITY;
+      }
+      child[i] = 0;
+      count[i] = 0;
+    }
+  }
+
+  /**
+   * @brief fill the next empty slot
+   */
+  void addChild(const AABB& box, int child, int count) {
+    for (int axis = 0; axis < 3; axis++) {
+      low[axis][size] = box.low[axis];
+      high[axis][size] = box.high[axis];
+    }
+    this->child[size] = child;
+    this->count[size] = count;
+    size++;
+  }
+
+  /**
+   * @brief the box of a slot
+   */
+  AABB getBox(int slot) const {
+    AABB box;
+    for (int axis = 0; axis < 3; axis++) {
+      box.low[axis] = low[axis][slot];
+      box.high[axis] = high[axis][slot];
+    }
+    return box;
+  }
+
+  /**
+   * @brief where each slot points: a node index for a node child, the first
+   * primitive in the index array for a leaf
+   */
+  void getChildren(int child[WIDTH], int count[WIDTH]) const {
+    for (int i = 0; i < WIDTH; i++) {
+      child[i] = this->child[i];
+      count[i] = this->count[i];
+    }
+  }
+
+  /**
+   * @brief slab test of a ray against the box of every child
+   * lane for lane the same decisions and entry distances as
+   * AABB::intersect(origin, inverse_direction, t_max, t_enter)
+   * @param origin the start of the ray, in every lane
+   * @param inverse_direction 1 / direction of the ray, in every lane
+   * @param t_max the far end of the interval that is searched
+   * @param t_enter set to the distance at which the ray enters each box
+   * @return bit i is set if the ray overlaps the box of slot i
+   */
+  int intersect(const Double4 origin[3],
+                const Double4 inverse_direction[3],
+                double t_max,
+                double t_enter[WIDTH]) const {
+    int mask = 0;
+    for (int first = 0; first < WIDTH; first += SIMD_WIDTH) {
+      Double4 enter(0.0);
+      Double4 exit(t_max);
+      for (int axis = 0; axis < 3; axis++) {
+        Double4 t0 = (Double4::load(&low[axis][first]) - origin[axis]) *
+                     inverse_direction[axis];
+        Double4 t1 = (Double4::load(&high[axis][first]) - origin[axis]) *
+                     inverse_direction[axis];
+        // a NaN distance is neither swapped nor taken, as in the scalar test
+        Mask4 swap = t0 > t1;
+        Double4 near = select(swap, t1, t0);
+        Double4 far = select(swap, t0, t1);
+        enter = select(near > enter, near, enter);
+        exit = select(far < exit, far, exit);
+      }
+      enter.store(&t_enter[first]);
+      mask |= (enter <= exit).bits() << first;
+    }
+    return mask & ((1 << size) - 1);
+  }
+};
+
+#endif  // WIDE_NODE_H
@@ -43,7 +43,7 @@ do
 done
 
 # compile the file
-g++ $gpp_args -o $filename.out -lGL -lGLU -lglut
+g++ $gpp_args -o $filename.out -lGL -lGLU -lglut -pthread
 
 # run the file
 ./$filename.out